@@ -26,11 +26,20 @@
 #include <bitcoin/blockchain/interface/block_chain.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
 #include <bitcoin/blockchain/interface/safe_chain.hpp>
+#include <bitcoin/blockchain/interface/transaction_view.hpp>
+#include <bitcoin/blockchain/pools/block_cache.hpp>
 #include <bitcoin/blockchain/pools/block_entry.hpp>
 #include <bitcoin/blockchain/pools/block_organizer.hpp>
 #include <bitcoin/blockchain/pools/block_pool.hpp>
 #include <bitcoin/blockchain/pools/branch.hpp>
+#include <bitcoin/blockchain/pools/header_index.hpp>
+#include <bitcoin/blockchain/pools/in_flight_transactions.hpp>
+#include <bitcoin/blockchain/pools/mempool_address_index.hpp>
+#include <bitcoin/blockchain/pools/merkle_tree.hpp>
+#include <bitcoin/blockchain/pools/short_id_table.hpp>
+#include <bitcoin/blockchain/pools/extra_transaction_cache.hpp>
 #include <bitcoin/blockchain/pools/transaction_entry.hpp>
+#include <bitcoin/blockchain/pools/transaction_entry_store.hpp>
 #include <bitcoin/blockchain/pools/transaction_organizer.hpp>
 #include <bitcoin/blockchain/pools/transaction_pool.hpp>
 #include <bitcoin/blockchain/populate/populate_base.hpp>
@@ -29,7 +29,14 @@
 #include <bitcoin/blockchain/define.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
 #include <bitcoin/blockchain/interface/safe_chain.hpp>
+#include <bitcoin/blockchain/interface/transaction_view.hpp>
+#include <bitcoin/blockchain/pools/block_cache.hpp>
 #include <bitcoin/blockchain/pools/block_organizer.hpp>
+#include <bitcoin/blockchain/pools/extra_transaction_cache.hpp>
+#include <bitcoin/blockchain/pools/header_index.hpp>
+#include <bitcoin/blockchain/pools/mempool_address_index.hpp>
+#include <bitcoin/blockchain/pools/merkle_tree.hpp>
+#include <bitcoin/blockchain/pools/short_id_table.hpp>
 #include <bitcoin/blockchain/pools/transaction_organizer.hpp>
 #include <bitcoin/blockchain/populate/populate_chain_state.hpp>
 #include <bitcoin/blockchain/settings.hpp>
@@ -177,14 +184,22 @@ public:
     // Node Queries.
     // ------------------------------------------------------------------------
 
-    /// fetch a block by height.
+    /// fetch a block by height (the handler is invoked before return).
     void fetch_block(size_t height, bool witness,
         block_fetch_handler handler) const override;
 
-    /// fetch a block by hash.
+    /// fetch a block by hash (the handler is invoked before return).
     void fetch_block(const hash_digest& hash, bool witness,
         block_fetch_handler handler) const override;
 
+    /// fetch the wire serialization of a block by height.
+    void fetch_block_raw(size_t height, bool witness,
+        block_raw_fetch_handler handler) const override;
+
+    /// fetch the wire serialization of a block by hash.
+    void fetch_block_raw(const hash_digest& hash, bool witness,
+        block_raw_fetch_handler handler) const override;
+
     void fetch_block_header_txs_size(const hash_digest& hash,
         block_header_txs_size_fetch_handler handler) const override;
 
@@ -276,6 +291,42 @@ public:
 
     void for_each_transaction_non_coinbase(size_t from, size_t to, bool witness, for_each_tx_handler const& handler) const;
 
+    using for_each_tx_view_handler = std::function<void(code const&, size_t, transaction_view const&)>;
+
+    /// Visit the transactions of the heights [from, to] as store views, which
+    /// are only deserialized on demand by the handler.
+    void for_each_transaction_view(size_t from, size_t to, bool witness, for_each_tx_view_handler const& handler) const;
+
+    /// Visit the transactions of the heights [from, to] using a worker thread
+    /// per configured core, stopping when the handler returns false. The
+    /// range is clamped to the top, not_found is reported if from is above
+    /// the top. If ordered, transactions are delivered in (height, position)
+    /// order on the calling thread. Otherwise they are delivered as read and
+    /// the handler may be invoked concurrently, but no call is started once
+    /// it has returned false. This call returns once the workers are joined.
+    void for_each_transaction_parallel(size_t from, size_t to, bool witness, bool ordered, for_each_tx_predicate const& handler) const;
+
+    void for_each_transaction_non_coinbase_parallel(size_t from, size_t to, bool witness, bool ordered, for_each_tx_predicate const& handler) const;
+
+    /// Stream the blocks [from, to] in height order, reading up to readahead
+    /// blocks ahead of the handler on a background thread. The stream ends
+    /// on the first error (passed to the handler) or when the handler returns
+    /// false. This call returns once the stream ends.
+    void fetch_blocks(size_t from, size_t to, bool witness, size_t readahead, block_stream_handler const& handler) const;
+
+    /// The number of block fetches served from the recent block cache.
+    size_t block_cache_hits() const;
+
+    /// The number of block fetches not served from the recent block cache.
+    size_t block_cache_misses() const;
+
+    /// The number of compact block slots filled from the extra transactions.
+    size_t extra_transaction_hits() const;
+
+    /// The number of compact block slots left to request after consulting
+    /// the extra transactions.
+    size_t extra_transaction_misses() const;
+
 
 
     // Server Queries.
@@ -371,12 +422,59 @@ public:
 #endif
     };
 
-    struct prev_output {
-        libbitcoin::hash_digest output_hash;
-        uint32_t output_index;
+    typedef std::shared_ptr<const tx_benefit> tx_benefit_const_ptr;
+
+    /// Set difference of the chosen list between two versions.
+    /// If full the since version is not in the history window, so added is
+    /// the whole chosen list (in selection order) and removed is empty.
+    struct gbt_delta {
+        size_t from_version;
+        size_t version;
+        bool full;
+        std::vector<tx_benefit_const_ptr> added;
+        hash_list removed;
+    };
+
+    /// The txids added to and removed from the chosen list by one snapshot.
+    /// Only txids are retained, so the history holds no transaction data.
+    struct gbt_change {
+        size_t from_version;
+        size_t version;
+        hash_list added;
+        hash_list removed;
     };
 
+    typedef std::shared_ptr<const gbt_change> gbt_change_ptr;
+
+    /// Immutable chosen list, in selection order (parents before children).
+    struct gbt_snapshot {
+        size_t version;
+        std::vector<tx_benefit_const_ptr> txs;
+
+        /// Coinbase merkle branch over the txids (coinbase excluded).
+        hash_list merkle_branch;
+
+        /// The transactions serialized back to back, in selection order.
+        /// Shared with the previous snapshot if the chosen list is the same.
+        std::shared_ptr<const data_chunk> payload;
+
+        /// The most recent changes, ending at this version (oldest first).
+        std::vector<gbt_change_ptr> history;
+    };
+
+    typedef std::shared_ptr<const gbt_snapshot> gbt_snapshot_ptr;
+
+    /// Get the chosen list as a copy of the latest snapshot.
     std::vector<block_chain::tx_benefit> get_gbt_tx_list() const;
+
+    /// Get the latest chosen list snapshot, never blocks and never copies.
+    gbt_snapshot_ptr get_gbt_snapshot() const;
+
+    /// Get the chosen list changes since the given snapshot version.
+    gbt_delta get_template_delta(size_t since_version) const;
+
+    /// Pool the stored transaction, false unless it is pooled on return.
+    /// Transactions evicted in making room are removed from the store.
     bool add_to_chosen_list(transaction_const_ptr tx) override;
     void remove_mined_txs_from_chosen_list(block_const_ptr blk) override;
 
@@ -408,12 +506,29 @@ private:
     //-------------------------------------------------------------------------
 
     code set_chain_state(chain::chain_state::ptr previous);
+    void read_block(const chain::header& header, const hash_list& tx_hashes,
+        size_t height, size_t generation, bool witness, const code& failure,
+        block_fetch_handler handler) const;
+    code read_transactions(const hash_list& tx_hashes,
+        chain::transaction::list& txs, size_t height, bool witness,
+        const code& failure, size_t bucket, size_t buckets) const;
+    void scan_transactions(size_t from, size_t to, bool witness,
+        bool ordered, bool skip_coinbase,
+        for_each_tx_predicate const& handler) const;
+    bool read_block_raw(data_chunk& out_data,
+        const database::block_result& result, bool witness) const;
+    void build_header_index();
+    void index_header(const chain::header& header, size_t height);
+    void build_mempool_index();
+    void index_unconfirmed(const chain::transaction& tx, uint32_t timestamp);
+    void remove_unconfirmed(const hash_list& hashes);
     void handle_transaction(const code& ec, transaction_const_ptr tx,
         result_handler handler) const;
     void handle_block(const code& ec, block_const_ptr block,
         result_handler handler) const;
-    void handle_reorganize(const code& ec, block_const_ptr top,
-        result_handler handler);
+    void handle_reorganize(const code& ec, size_t fork_height,
+        block_const_ptr_list_const_ptr incoming_blocks,
+        block_const_ptr_list_ptr outgoing_blocks, result_handler handler);
 
     // These are thread safe.
     std::atomic<bool> stopped_;
@@ -423,6 +538,11 @@ private:
     bc::atomic<transaction_const_ptr> last_transaction_;
     const populate_chain_state chain_state_populator_;
     database::data_base database_;
+    header_index header_index_;
+    mempool_address_index mempool_address_index_;
+    short_id_table short_id_table_;
+    mutable block_cache block_cache_;
+    mutable extra_transaction_cache extra_transactions_;
 
     // This is protected by mutex.
     chain::chain_state::ptr pool_state_;
@@ -432,26 +552,18 @@ private:
     mutable prioritized_mutex validation_mutex_;
     mutable threadpool priority_pool_;
     mutable dispatcher dispatch_;
+    mutable threadpool read_pool_;
+    mutable dispatcher read_dispatch_;
     transaction_organizer transaction_organizer_;
     block_organizer block_organizer_;
 
-    bool get_transaction_is_confirmed(libbitcoin::hash_digest tx_hash);
-    void append_spend(transaction_const_ptr tx);
-    void remove_spend(libbitcoin::hash_digest const& hash);
-    bool check_is_double_spend(transaction_const_ptr tx);
-    std::set<libbitcoin::hash_digest> get_double_spend_chosen_list(transaction_const_ptr tx);
-    bool insert_to_chosen_list(transaction_const_ptr& tx, double benefit, size_t tx_size, size_t tx_sigops);
-    size_t find_txs_to_remove_from_chosen(const size_t sigops_limit, const size_t tx_size,
-        const size_t tx_sigops, const size_t tx_fees, const double benefit,
-            size_t& acum_sigops, size_t& acum_size, double& acum_benefit);
-
-
-    uint64_t chosen_size_; // Size in bytes of the chosen unconfirmed transaction list
-    uint64_t chosen_sigops_; // Total Amount of sigops in the chosen unconfirmed transaction list
-    std::list <tx_benefit> chosen_unconfirmed_; // Chosen unconfirmed transaction list
-    std::unordered_map<hash_digest, std::vector<prev_output>> chosen_spent_;
-    mutable std::mutex gbt_mutex_; // Protect chosen unconfirmed transaction list
-    std::atomic_bool gbt_ready_; // Getblocktemplate ready
+    code check_prevouts(transaction_const_ptr tx) const;
+    gbt_snapshot_ptr publish_gbt_snapshot() const;
+
+    mutable std::mutex gbt_mutex_; // Serializes chosen list publication
+    mutable merkle_tree gbt_merkle_; // Protected by gbt_mutex_
+    std::atomic<size_t> gbt_version_; // Incremented on each pool change
+    mutable bc::atomic<gbt_snapshot_ptr> gbt_snapshot_; // Latest published chosen list
 
 
 #endif
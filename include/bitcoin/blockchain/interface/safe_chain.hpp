@@ -47,6 +47,7 @@ public:
     typedef handle1<chain::history_compact::list> history_fetch_handler;
     typedef handle1<chain::stealth_compact::list> stealth_fetch_handler;
     typedef handle2<size_t, size_t> transaction_index_fetch_handler;
+    typedef handle2<data_chunk, size_t> block_raw_fetch_handler;
 
     typedef handle1<std::vector<hash_digest>> confirmed_transactions_fetch_handler;
 
@@ -85,6 +86,12 @@ public:
 
     using for_each_tx_handler = std::function<void(code const&, size_t, chain::transaction const&)>;
 
+    // Return false to stop the scan.
+    using for_each_tx_predicate = std::function<bool(code const&, size_t, chain::transaction const&)>;
+
+    // Return false to stop the stream.
+    using block_stream_handler = std::function<bool(code const&, block_const_ptr, size_t)>;
+
 
     using mempool_mini_hash_map = std::unordered_map<mini_hash, chain::transaction>;
 
@@ -104,6 +111,12 @@ public:
     virtual void fetch_block(const hash_digest& hash, bool witness,
         block_fetch_handler handler) const = 0;
 
+    virtual void fetch_block_raw(size_t height, bool witness,
+        block_raw_fetch_handler handler) const = 0;
+
+    virtual void fetch_block_raw(const hash_digest& hash, bool witness,
+        block_raw_fetch_handler handler) const = 0;
+
     virtual void fetch_block_header(size_t height,
         block_header_fetch_handler handler) const = 0;
 
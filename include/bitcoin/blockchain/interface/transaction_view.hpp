@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_TRANSACTION_VIEW_HPP
+#define LIBBITCOIN_BLOCKCHAIN_TRANSACTION_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is not thread safe.
+/// Read-only view of a stored transaction, valid only for the duration of the
+/// handler invocation that receives it. Metadata is read from the store
+/// record without deserialization, an output is parsed only when requested
+/// and the full transaction only when transaction() is called.
+class BCB_API transaction_view
+{
+public:
+    /// An invalid view, passed with error codes.
+    transaction_view();
+
+    transaction_view(const database::transaction_result& result, bool witness);
+
+    /// True if the view refers to a stored transaction.
+    operator bool() const;
+
+    /// The transaction hash.
+    const hash_digest& hash() const;
+
+    /// The height of the block containing the transaction.
+    size_t height() const;
+
+    /// The position of the transaction within its block.
+    size_t position() const;
+
+    /// Parse only the output at the given index.
+    chain::output output(uint32_t index) const;
+
+    /// Deserialize the full transaction.
+    chain::transaction transaction() const;
+
+private:
+    const database::transaction_result* result_;
+    bool witness_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
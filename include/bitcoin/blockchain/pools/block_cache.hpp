@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_BLOCK_CACHE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_BLOCK_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// Least recently used cache of confirmed blocks, bounded by the sum of the
+/// serialized sizes of the cached blocks. Blocks are indexed by hash and by
+/// height, a block added at a cached height replaces the cached block.
+class BCB_API block_cache
+{
+public:
+    /// A zero capacity disables the cache.
+    block_cache(size_t capacity);
+
+    /// The configured capacity in bytes.
+    size_t capacity() const;
+
+    /// The number of cached blocks.
+    size_t size() const;
+
+    /// The sum of the serialized sizes of the cached blocks.
+    size_t bytes() const;
+
+    /// The number of successful lookups.
+    size_t hits() const;
+
+    /// The number of unsuccessful lookups.
+    size_t misses() const;
+
+    /// The number of removals, read before a block is read from the store.
+    size_t generation() const;
+
+    /// Add the block at the given height, evicting the least recently used.
+    void add(block_const_ptr block, size_t height);
+
+    /// Add the block as above, unless a block has been removed since the
+    /// generation was read (the block read may have been reorganized out).
+    void add(block_const_ptr block, size_t height, size_t generation);
+
+    /// Remove the block of the given hash if cached.
+    void remove(const hash_digest& hash);
+
+    /// Remove all entries.
+    void clear();
+
+    /// The cached block at the given height, or nullptr.
+    block_const_ptr get(size_t height) const;
+
+    /// The cached block of the given hash and its height, or nullptr.
+    block_const_ptr get(size_t& out_height, const hash_digest& hash) const;
+
+private:
+    struct entry
+    {
+        block_const_ptr block;
+        hash_digest hash;
+        size_t height;
+        size_t size;
+    };
+
+    typedef std::list<entry> entries;
+    typedef entries::iterator iterator;
+
+    void insert(block_const_ptr block, const hash_digest& hash,
+        size_t height, size_t size);
+    void erase(iterator it);
+    void touch(iterator it) const;
+
+    // This is thread safe.
+    const size_t capacity_;
+    mutable std::atomic<size_t> hits_;
+    mutable std::atomic<size_t> misses_;
+
+    // These are guarded, lookups reorder the entries (front is most recent).
+    mutable entries entries_;
+    std::unordered_map<hash_digest, iterator> hashes_;
+    std::unordered_map<size_t, iterator> heights_;
+    size_t bytes_;
+    size_t generation_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_EXTRA_TRANSACTION_CACHE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_EXTRA_TRANSACTION_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// Bounded ring of recently seen transactions that are not pooled (such as
+/// rejected and orphan transactions), which may yet be mined. Compact block
+/// reconstruction consults it for the short ids the pool does not resolve.
+class BCB_API extra_transaction_cache
+{
+public:
+    typedef std::unordered_map<uint64_t, uint16_t> short_id_map;
+
+    /// A zero capacity disables the cache.
+    extra_transaction_cache(size_t capacity);
+
+    /// The configured capacity in transactions.
+    size_t capacity() const;
+
+    /// The number of cached transactions.
+    size_t size() const;
+
+    /// The number of block slots filled from the cache.
+    size_t hits() const;
+
+    /// The number of short id slots left unfilled after consulting the cache.
+    size_t misses() const;
+
+    /// Add the transaction, replacing the oldest if full.
+    void add(transaction_const_ptr tx);
+
+    /// Fill the empty slots of txn_available whose short ids match a cached
+    /// transaction, incrementing out_count for each. A slot filled with a
+    /// different transaction matching the same short id is emptied instead,
+    /// and is not filled again by this call.
+    void fill(std::vector<chain::transaction>& txn_available,
+        size_t& out_count, uint64_t k0, uint64_t k1,
+        const short_id_map& short_ids);
+
+private:
+    const size_t capacity_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+
+    // These are protected by mutex.
+    std::vector<transaction_const_ptr> ring_;
+    hash_list id_hashes_;
+    size_t next_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_HEADER_INDEX_HPP
+#define LIBBITCOIN_BLOCKCHAIN_HEADER_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// In-memory index of the confirmed chain headers, keyed by height.
+/// Each header field is held in its own column (structure of arrays) so that
+/// height-range scans (retarget and median time past windows) touch only the
+/// field in question. The index always covers the contiguous range [0, size).
+/// The cumulative proof of work through each height is also maintained, so
+/// that the work of any height range is the difference of two entries.
+class BCB_API header_index
+{
+public:
+    header_index();
+
+    /// The number of indexed heights (top indexed height plus one).
+    size_t size() const;
+
+    /// Preallocate column storage for the given number of heights.
+    void reserve(size_t size);
+
+    /// Append the header at the given height, false if height != size().
+    bool push(const chain::header& header, size_t height);
+
+    /// Remove all heights above the given height (fork point).
+    void pop_above(size_t height);
+
+    /// Remove all entries.
+    void clear();
+
+    /// The hash of the block at the given height.
+    bool get_block_hash(hash_digest& out_hash, size_t height) const;
+
+    /// The bits of the block at the given height.
+    bool get_bits(uint32_t& out_bits, size_t height) const;
+
+    /// The timestamp of the block at the given height.
+    bool get_timestamp(uint32_t& out_timestamp, size_t height) const;
+
+    /// The version of the block at the given height.
+    bool get_version(uint32_t& out_version, size_t height) const;
+
+    /// The header of the block at the given height.
+    bool get_header(chain::header& out_header, size_t height) const;
+
+    /// The work of the heights [from, to], false if to is not indexed.
+    /// Accumulation stops at the first height that reaches the maximum.
+    bool get_branch_work(uint256_t& out_work, const uint256_t& maximum,
+        size_t from_height, size_t to_height) const;
+
+private:
+    hash_list hashes_;
+    hash_list merkles_;
+    std::vector<uint32_t> bits_;
+    std::vector<uint32_t> timestamps_;
+    std::vector<uint32_t> versions_;
+    std::vector<uint32_t> nonces_;
+    std::vector<uint256_t> works_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
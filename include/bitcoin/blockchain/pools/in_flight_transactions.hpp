@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_IN_FLIGHT_TRANSACTIONS_HPP
+#define LIBBITCOIN_BLOCKCHAIN_IN_FLIGHT_TRANSACTIONS_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// The transactions being organized and the outpoints they spend. A
+/// transaction spending an outpoint spent by one in flight is a double spend,
+/// and one spending an output of a transaction in flight is deferred until
+/// that transaction is released.
+class BCB_API in_flight_transactions
+{
+public:
+    typedef handle0 result_handler;
+    typedef std::pair<transaction_const_ptr, result_handler> deferred;
+    typedef std::vector<deferred> deferred_list;
+
+    /// The number of transactions in flight.
+    size_t size() const;
+
+    /// True if the transaction is put in flight. False with
+    /// duplicate_transaction if it is already in flight, false with
+    /// double_spend if an outpoint is spent by another transaction in flight,
+    /// or false with success if the transaction is deferred on a parent in
+    /// flight.
+    bool reserve(transaction_const_ptr tx, result_handler handler,
+        code& out_ec);
+
+    /// Release the transaction and its spends, returning the transactions
+    /// deferred on it (in order of deferral).
+    deferred_list release(transaction_const_ptr tx);
+
+private:
+    // These are protected by mutex.
+    std::unordered_set<chain::point> spends_;
+    std::unordered_map<hash_digest, deferred_list> in_flight_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_MEMPOOL_ADDRESS_INDEX_HPP
+#define LIBBITCOIN_BLOCKCHAIN_MEMPOOL_ADDRESS_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// In-memory index of the unconfirmed transactions by payment address, kept
+/// current as transactions enter and leave the unconfirmed table, so address
+/// queries cost the number of results. Addresses are indexed in mainnet form
+/// and may be queried in mainnet or testnet form. Spends are indexed by the
+/// address and value of the spent output, captured when indexed.
+class BCB_API mempool_address_index
+{
+public:
+    struct row
+    {
+        hash_digest hash;
+        uint32_t index;
+
+        /// True for an input (spend), false for an output (receive).
+        bool spend;
+        uint64_t value;
+
+        /// Valid only for a spend.
+        chain::output_point previous_output;
+        uint32_t timestamp;
+    };
+
+    typedef std::vector<row> list;
+
+    mempool_address_index();
+
+    /// The number of indexed transactions.
+    size_t size() const;
+
+    /// Index the outputs and inputs of the transaction, where prevouts holds
+    /// the output spent by each input (in input order). Inputs with an
+    /// invalid (unresolved) prevout are not indexed.
+    void add(const chain::transaction& tx, const chain::output::list& prevouts,
+        uint32_t timestamp);
+
+    /// Remove the transaction from the index, if indexed.
+    void remove(const hash_digest& hash);
+
+    /// Remove all entries.
+    void clear();
+
+    /// The indexed rows of the address, grouped by transaction (the order of
+    /// the transactions is unspecified).
+    list get(const wallet::payment_address& address) const;
+
+private:
+    typedef std::vector<wallet::payment_address> addresses;
+
+    // The rows of an address keyed by transaction, for constant time removal.
+    typedef std::unordered_map<hash_digest, list> transactions;
+
+    static wallet::payment_address normalize(
+        const wallet::payment_address& address);
+
+    // These are protected by mutex.
+    std::unordered_map<wallet::payment_address, transactions> rows_;
+    std::unordered_map<hash_digest, addresses> addresses_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
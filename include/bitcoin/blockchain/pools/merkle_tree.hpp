@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_MERKLE_TREE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_MERKLE_TREE_HPP
+
+#include <cstddef>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is not thread safe.
+/// Merkle tree over an ordered list of leaves, retaining every level so that
+/// an update rehashes only the nodes above the first changed leaf. The first
+/// leaf of a template tree is the coinbase, which is not known to the node,
+/// so its branch is exposed for the miner to compute the root.
+class BCB_API merkle_tree
+{
+public:
+    merkle_tree();
+
+    /// The number of leaves.
+    size_t size() const;
+
+    /// Replace the leaves, rehashing only nodes above the changed suffix.
+    void update(const hash_list& leaves);
+
+    /// The merkle branch of the first leaf, from the leaf level up.
+    hash_list branch() const;
+
+    /// The root, given the hash of the first leaf.
+    hash_digest root(const hash_digest& first) const;
+
+private:
+    std::vector<hash_list> levels_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
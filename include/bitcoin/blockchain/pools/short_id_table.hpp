@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_SHORT_ID_TABLE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_SHORT_ID_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is thread safe.
+/// The hashes of the unconfirmed transactions from which compact block
+/// (BIP152) short ids are computed, held in a contiguous array so that the
+/// short ids for the keys of a new block are computed in one pass. Each entry
+/// also holds the txid, by which the transaction is read from the store.
+class BCB_API short_id_table
+{
+public:
+    typedef std::unordered_map<uint64_t, uint16_t> short_id_map;
+    typedef std::vector<std::pair<uint64_t, hash_digest>> short_id_list;
+
+    /// The 48 bit short id of the hash for the given SipHash keys.
+    static uint64_t short_id(uint64_t k0, uint64_t k1, const hash_digest& hash);
+
+    short_id_table();
+
+    /// The number of entries.
+    size_t size() const;
+
+    /// Add the transaction by txid and by the hash of its short id.
+    void add(const hash_digest& txid, const hash_digest& id_hash);
+
+    /// Remove the transaction by txid, if present.
+    void remove(const hash_digest& txid);
+
+    /// Remove all entries.
+    void clear();
+
+    /// Set out_txids[slot] to the txid of the one entry whose short id maps to
+    /// the slot. A slot matched by more than one entry is marked ambiguous
+    /// and left as null_hash, to be requested as missing (txids are not
+    /// compared). Matching stops once every slot is resolved, so a later
+    /// collision is not detected. Returns the number of resolved slots.
+    /// Slots must be in range.
+    size_t resolve(hash_list& out_txids, uint64_t k0, uint64_t k1,
+        const short_id_map& short_ids) const;
+
+    /// The short id and txid of every entry.
+    short_id_list short_ids(uint64_t k0, uint64_t k1) const;
+
+private:
+    // These are protected by mutex.
+    hash_list id_hashes_;
+    hash_list txids_;
+    std::unordered_map<hash_digest, size_t> positions_;
+    mutable shared_mutex mutex_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
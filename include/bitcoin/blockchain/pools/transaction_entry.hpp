@@ -22,9 +22,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <memory>
 #include <vector>
-#include <boost/functional/hash_fwd.hpp>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
 
@@ -32,11 +30,17 @@ namespace libbitcoin {
 namespace blockchain {
 
 /// This class is not thread safe.
+/// Pooled entries are held by value in a transaction_entry_store and refer
+/// to one another by 32 bit handles. The parent and child links are
+/// intrusive lists of store edges, so an entry owns no heap allocations.
 class BCB_API transaction_entry
 {
 public:
-    typedef std::shared_ptr<transaction_entry> ptr;
-    typedef std::vector<ptr> list;
+    typedef uint32_t handle;
+    typedef std::vector<transaction_entry> list;
+
+    /// The handle of no entry (or edge).
+    static const handle null_handle;
 
     /// Construct an entry for the pool.
     /// Never store an invalid transaction in the pool except for the cases of:
@@ -66,46 +70,81 @@ public:
     /// The hash table entry identity.
     const hash_digest& hash() const;
 
-    /// Used for DAG traversal.
-    void mark(bool value);
+    /// The pooled transaction, null if the entry is a search key.
+    transaction_const_ptr transaction() const;
 
-    /// Used for DAG traversal.
-    bool is_marked() const;
+    /// The number of pooled ancestors, including this entry.
+    size_t ancestor_count() const;
+
+    /// The size of the pooled ancestors, including this entry.
+    size_t ancestor_size() const;
+
+    /// The fees of the pooled ancestors, including this entry.
+    uint64_t ancestor_fees() const;
+
+    /// The sigops of the pooled ancestors, including this entry.
+    size_t ancestor_sigops() const;
+
+    /// The fees per byte of the pooled ancestors, including this entry.
+    double ancestor_score() const;
+
+    /// Set the aggregates of the pooled ancestors, including this entry.
+    void set_ancestors(size_t count, size_t size, uint64_t fees,
+        size_t sigops);
 
-    /// The hash table entry's parent (prevout transaction) hashes.
-    const list& parents() const;
+    /// The number of pooled descendants, including this entry.
+    size_t descendant_count() const;
 
-    /// The hash table entry's child (input transaction) hashes.
-    const list& children() const;
+    /// The size of the pooled descendants, including this entry.
+    size_t descendant_size() const;
 
-    /// Add transaction to the list of children of this transaction.
-    void add_parent(ptr parent);
+    /// The fees of the pooled descendants, including this entry.
+    uint64_t descendant_fees() const;
 
-    /// Add transaction to the list of children of this transaction.
-    void add_child(ptr child);
+    /// The fees per byte of the pooled descendants, including this entry.
+    double descendant_score() const;
 
-    /// Parents are never removed, as this invalidates the child.
-    /// Removal of a child causing the subgraph connected to it to be pruned.
-    void remove_child(ptr child);
+    /// Set the aggregates of the pooled descendants, including this entry.
+    void set_descendants(size_t count, size_t size, uint64_t fees);
+
+    /// Used for DAG traversal.
+    void mark(bool value);
+
+    /// Used for DAG traversal.
+    bool is_marked() const;
 
     /// Serializer for debugging (temporary).
     friend std::ostream& operator<<(std::ostream& out,
         const transaction_entry& of);
 
 private:
+    friend class transaction_entry_store;
+
     // These are non-const to allow for default copy construction.
     uint64_t fees_;
     uint32_t forks_;
     uint32_t sigops_;
     uint32_t size_;
     hash_digest hash_;
+    transaction_const_ptr transaction_;
+
+    // Maintained by the pool as ancestors are added and removed.
+    uint32_t ancestor_count_;
+    uint32_t ancestor_size_;
+    uint64_t ancestor_fees_;
+    uint32_t ancestor_sigops_;
+
+    // Maintained by the pool as descendants are added and removed.
+    uint32_t descendant_count_;
+    uint32_t descendant_size_;
+    uint64_t descendant_fees_;
 
     // Used in DAG search.
     bool marked_;
 
-    // These do not affect the entry hash, so must be mutable.
-    list parents_;
-    list children_;
+    // The heads of the parent and child edge lists, maintained by the store.
+    handle parents_;
+    handle children_;
 };
 
 } // namespace blockchain
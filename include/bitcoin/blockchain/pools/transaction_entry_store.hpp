@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_BLOCKCHAIN_TRANSACTION_ENTRY_STORE_HPP
+#define LIBBITCOIN_BLOCKCHAIN_TRANSACTION_ENTRY_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+#include <bitcoin/blockchain/pools/transaction_entry.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+/// This class is not thread safe.
+/// Slab of transaction entries addressed by 32 bit handles, with the parent
+/// and child links of each entry held as intrusive lists in a slab of edges.
+/// Freed entry and edge slots are reused, so once the pool has reached its
+/// working size adding and removing entries does not allocate.
+class BCB_API transaction_entry_store
+{
+public:
+    typedef transaction_entry::handle handle;
+    typedef std::vector<handle> handles;
+
+    transaction_entry_store();
+
+    /// The number of stored entries.
+    size_t size() const;
+
+    /// The number of entry slots (stored and free).
+    size_t capacity() const;
+
+    /// Store the entry, returns its handle.
+    handle insert(transaction_entry&& entry);
+
+    /// Remove the entry and its links to parents and children.
+    void erase(handle entry);
+
+    /// The entry of the given handle, which must be stored.
+    transaction_entry& get(handle entry);
+    const transaction_entry& get(handle entry) const;
+
+    /// Link the parent to the child, false if already linked.
+    bool link(handle parent, handle child);
+
+    /// Append the handles of the entry's parents.
+    void parents(handle entry, handles& out) const;
+
+    /// Append the handles of the entry's children.
+    void children(handle entry, handles& out) const;
+
+private:
+    struct edge
+    {
+        handle entry;
+        handle next;
+    };
+
+    handle allocate_edge(handle entry, handle next);
+    void unlink(handle& head, handle entry);
+    void release(handle head);
+
+    std::vector<transaction_entry> entries_;
+    std::vector<edge> edges_;
+    handles free_entries_;
+    handles free_edges_;
+};
+
+} // namespace blockchain
+} // namespace libbitcoin
+
+#endif
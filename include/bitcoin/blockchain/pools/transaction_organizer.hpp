@@ -28,6 +28,7 @@
 #include <bitcoin/blockchain/define.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
 #include <bitcoin/blockchain/interface/safe_chain.hpp>
+#include <bitcoin/blockchain/pools/in_flight_transactions.hpp>
 #include <bitcoin/blockchain/pools/transaction_pool.hpp>
 #include <bitcoin/blockchain/settings.hpp>
 #include <bitcoin/blockchain/validate/validate_transaction.hpp>
@@ -37,6 +38,11 @@ namespace blockchain {
 
 /// This class is thread safe.
 /// Organises transactions via the transaction pool to the blockchain.
+/// Transactions are checked, accepted and connected concurrently, only the
+/// push to the store is serialized (under the low priority lock). A
+/// transaction spending an outpoint spent by one in flight is rejected as a
+/// double spend, and one spending an output of a transaction in flight is
+/// deferred until that transaction completes.
 class BCB_API transaction_organizer
 {
 public:
@@ -47,7 +53,8 @@ public:
     typedef safe_chain::merkle_block_fetch_handler merkle_block_fetch_handler;
     typedef resubscriber<code, transaction_const_ptr> transaction_subscriber;
 
-    /// Construct an instance.
+    /// Construct an instance, the push is dispatched to a dedicated thread,
+    /// which is started by start and released by stop.
     transaction_organizer(prioritized_mutex& mutex, dispatcher& dispatch,
         threadpool& thread_pool, fast_chain& chain, const settings& settings);
 
@@ -60,20 +67,36 @@ public:
     void subscribe(transaction_handler&& handler);
     void unsubscribe();
 
+    /// Fetch the pool's template for the height above the current top.
     void fetch_template(merkle_block_fetch_handler) const;
-    void fetch_mempool(size_t maximum, inventory_fetch_handler) const;
+    void fetch_mempool(size_t maximum, uint64_t minimum_fee,
+        inventory_fetch_handler) const;
+
+    /// The pool of validated unconfirmed transactions.
+    transaction_pool& pool();
+    const transaction_pool& pool() const;
 
 protected:
     bool stopped() const;
     uint64_t price(transaction_const_ptr tx) const;
 
 private:
+    // In flight sub-sequence.
+    void handle_complete(code const& ec, transaction_const_ptr tx,
+        result_handler handler);
+
     // Verify sub-sequence.
     void handle_check(code const& ec, transaction_const_ptr tx, result_handler handler);
     void handle_accept(code const& ec, transaction_const_ptr tx, result_handler handler);
     void handle_connect(code const& ec, transaction_const_ptr tx, result_handler handler);
+    void push(transaction_const_ptr tx, result_handler handler);
     void handle_pushed(code const& ec, transaction_const_ptr tx, result_handler handler);
-    void signal_completion(code const& ec);
+
+    // Reaccept sub-sequence.
+    void reaccept(transaction_const_ptr tx, result_handler handler);
+    void handle_reaccept(code const& ec, transaction_const_ptr tx,
+        uint32_t forks, const chain::output::list& prevouts,
+        result_handler handler);
 
     void validate_handle_check(code const& ec, transaction_const_ptr tx, result_handler handler) const;
     void validate_handle_accept(code const& ec, transaction_const_ptr tx, result_handler handler) const;
@@ -88,12 +111,14 @@ private:
     // These are thread safe.
     prioritized_mutex& mutex_;
     std::atomic<bool> stopped_;
-    std::promise<code> resume_;
     const settings& settings_;
     dispatcher& dispatch_;
+    threadpool push_pool_;
+    dispatcher push_dispatch_;
     transaction_pool transaction_pool_;
     validate_transaction validator_;
     transaction_subscriber::ptr subscriber_;
+    in_flight_transactions in_flight_;
 };
 
 } // namespace blockchain
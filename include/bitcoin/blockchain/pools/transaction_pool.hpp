@@ -21,15 +21,36 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
 #include <bitcoin/blockchain/interface/safe_chain.hpp>
+#include <bitcoin/blockchain/pools/transaction_entry.hpp>
+#include <bitcoin/blockchain/pools/transaction_entry_store.hpp>
 #include <bitcoin/blockchain/settings.hpp>
 
 namespace libbitcoin {
 namespace blockchain {
 
-/// TODO: this class is not implemented or utilized.
+/// This class is thread safe.
+/// Unconfirmed transactions linked by their parent/child spends (a DAG).
+/// Each entry carries the aggregates of its pooled ancestors (its package),
+/// maintained as transactions are added and removed, and entries are indexed
+/// by package feerate. Templates are selected greedily by package feerate, so
+/// a high fee child pulls in its low fee parents (child pays for parent).
+/// Entries are also bucketed by their own feerate for mempool replies.
+/// The template selection is retained until the pool next changes.
+/// Entries are held by value in a slab store and indexed by handle.
+/// The aggregates of pooled descendants are also maintained. When the pool
+/// exceeds its byte capacity the package of lowest descendant feerate is
+/// evicted and the minimum feerate for admission is raised above it. This
+/// minimum decays (halving every twelve hours) once the pool stops filling.
 class BCB_API transaction_pool
 {
 public:
@@ -38,10 +59,125 @@ public:
 
     transaction_pool(const settings& settings);
 
-    void fetch_template(merkle_block_fetch_handler) const;
-    void fetch_mempool(size_t maximum, inventory_fetch_handler) const;
+    /// Construct with the given template size limit, in bytes.
+    /// The pool capacity is settings.transaction_pool_capacity, in
+    /// serialized bytes, with zero disabling eviction.
+    transaction_pool(const settings& settings, size_t max_template_size);
+
+    /// Fetch the template transaction hashes at the given (next) height,
+    /// in selection order and excluding the coinbase, as a merkle block.
+    void fetch_template(size_t height, merkle_block_fetch_handler) const;
+
+    /// Fetch the inventory of up to maximum pooled transactions with a
+    /// feerate of at least minimum_fee (satoshis per kilobyte), highest
+    /// feerate first and ordered so that parents precede their children.
+    void fetch_mempool(size_t maximum, uint64_t minimum_fee,
+        inventory_fetch_handler) const;
+
+    /// The number of pooled transactions.
+    size_t size() const;
+
+    /// True if the transaction is pooled.
+    bool exists(const hash_digest& hash) const;
+
+    /// The serialized size of the pooled transactions.
+    size_t bytes() const;
+
+    /// The minimum feerate for admission (satoshis per kilobyte), zero
+    /// unless the pool has recently evicted.
+    uint64_t minimum_fee() const;
+
+    /// Pool a validated transaction, its unconfirmed parents must be pooled.
+    /// Conflicts with pooled spends are rejected (first seen wins).
+    /// The transaction is rejected with insufficient_fee if it is evicted
+    /// in restoring the pool capacity.
+    code add(transaction_const_ptr tx);
+
+    /// As add, with the hashes of all entries evicted in restoring the pool
+    /// capacity (possibly including the transaction) appended to the list.
+    code add(transaction_const_ptr tx, hash_list& out_evicted);
+
+    /// Remove the transactions confirmed by the block, anchoring their pooled
+    /// children, and remove pooled conflicts of the block with descendants.
+    void remove(block_const_ptr block);
+
+    /// Select the maximal fee template within the size and sigop limits.
+    /// Entries are copies in selection order, so parents precede children.
+    transaction_entry::list select() const;
+
+    /// The maintained template selection, reselected only if the pool has
+    /// changed since the last call.
+    transaction_entry::list selection() const;
+
+private:
+    typedef transaction_entry_store::handle handle;
+    typedef transaction_entry_store::handles handles;
+
+    // Aggregates of an ancestor package.
+    struct package
+    {
+        size_t size;
+        uint64_t fees;
+        size_t sigops;
+    };
+
+    // Descending package feerate, ties broken by hash.
+    struct score_compare
+    {
+        bool operator()(handle left, handle right) const;
+
+        const transaction_entry_store* store;
+    };
+
+    typedef std::set<handle, score_compare> score_index;
+
+    // Ascending descendant feerate, ties broken by hash.
+    struct eviction_compare
+    {
+        bool operator()(handle left, handle right) const;
+
+        const transaction_entry_store* store;
+    };
+
+    typedef std::set<handle, eviction_compare> eviction_index;
+
+    // Entries keyed by their own feerate (satoshis per kilobyte).
+    typedef std::unordered_set<handle> feerate_bucket;
+    typedef std::map<uint64_t, feerate_bucket> feerate_index;
+
+    bool fits(size_t size, size_t sigops) const;
+    void add_ancestors(handle entry);
+    void evict(hash_list& out_evicted);
+    uint64_t decayed_minimum_fee(std::time_t now) const;
+    void remove_confirmed(handle entry);
+    void remove_conflict(handle entry);
+    void erase(handle entry);
+
+    handles ancestors(handle entry) const;
+    handles descendants(handle entry) const;
+    static uint64_t feerate(const transaction_entry& entry);
+
+    const size_t max_template_size_;
+    const size_t capacity_;
+
+    // These are protected by mutex.
+    transaction_entry_store store_;
+    std::unordered_map<hash_digest, handle> entries_;
+    std::unordered_map<chain::point, handle> spenders_;
+    score_index index_;
+    eviction_index eviction_;
+    feerate_index buckets_;
+    size_t bytes_;
+    uint64_t minimum_fee_;
+    std::time_t minimum_fee_time_;
+    size_t version_;
+    mutable shared_mutex mutex_;
+
+    // These are protected by selection mutex.
+    mutable transaction_entry::list selection_;
+    mutable size_t selection_version_;
+    mutable std::mutex selection_mutex_;
 
-////private:
 ////    const bool reject_conflicts_;
 ////    const uint64_t minimum_fee_;
 };
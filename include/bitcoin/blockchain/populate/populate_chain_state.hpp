@@ -21,6 +21,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
@@ -29,7 +31,7 @@
 
 namespace libbitcoin { namespace blockchain {
 
-/// This class is NOT thread safe.
+/// This class is thread safe.
 class BCB_API populate_chain_state {
 public:
     populate_chain_state(const fast_chain& chain, const settings& settings);
@@ -48,10 +50,27 @@ private:
     typedef chain::chain_state::map map;
     typedef chain::chain_state::data data;
 
+    // The most recently populated windows, keyed by the parent block hash.
+    struct window
+    {
+        size_t height;
+        hash_digest parent;
+        chain::chain_state::map ranges;
+        chain::chain_state::data values;
+    };
+
+    typedef std::shared_ptr<const window> window_ptr;
+
+    window_ptr get_window(size_t height, branch_ptr branch) const;
+    void set_window(const data& data, const map& map, branch_ptr branch) const;
+
     bool populate_all(data& data, branch_ptr branch) const;
-    bool populate_bits(data& data, const map& map, branch_ptr branch) const;
-    bool populate_versions(data& data, const map& map, branch_ptr branch) const;
-    bool populate_timestamps(data& data, const map& map, branch_ptr branch) const;
+    bool populate_bits(data& data, const map& map, branch_ptr branch,
+        window_ptr previous) const;
+    bool populate_versions(data& data, const map& map, branch_ptr branch,
+        window_ptr previous) const;
+    bool populate_timestamps(data& data, const map& map, branch_ptr branch,
+        window_ptr previous) const;
     bool populate_collision(data& data, const map& map, branch_ptr branch) const;
     bool populate_bip9_bit0(data& data, const map& map, branch_ptr branch) const;
     bool populate_bip9_bit1(data& data, const map& map, branch_ptr branch) const;
@@ -69,9 +88,12 @@ private:
     const uint32_t configured_forks_;
     const config::checkpoint::list checkpoints_;
 
-    // Populate is guarded against concurrent callers but because it uses the fast
-    // chain it must not be invoked during chain writes.
+    // Populate may be invoked concurrently but because it uses the fast chain
+    // it must not be invoked during chain writes.
     const fast_chain& fast_chain_;
+
+    // Only the window pointer is guarded, population is not serialized.
+    mutable window_ptr window_;
     mutable shared_mutex mutex_;
 };
 
@@ -44,6 +44,9 @@ public:
     uint64_t minimum_output_satoshis;
     uint32_t notify_limit_hours;
     uint32_t reorganization_limit;
+    uint64_t block_cache_capacity;
+    uint32_t extra_transaction_capacity;
+    uint64_t transaction_pool_capacity;
     config::checkpoint::list checkpoints;
     bool allow_collisions;
     bool easy_blocks;
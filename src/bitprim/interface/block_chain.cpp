@@ -18,6 +18,19 @@
  */
 #include <bitcoin/blockchain/interface/block_chain.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace libbitcoin {
 namespace blockchain {
 
@@ -81,5 +94,319 @@ void block_chain::for_each_transaction_non_coinbase(size_t from, size_t to, bool
     }
 }
 
+void block_chain::for_each_transaction_view(size_t from, size_t to, bool witness, for_each_tx_view_handler const& handler) const {
+#ifdef BITPRIM_CURRENCY_BCH
+    witness = false;
+#endif
+    auto const& tx_store = database_.transactions();
+
+    while (from <= to) {
+
+        if (stopped()) {
+            handler(error::service_stopped, 0, transaction_view{});
+            return;
+        }
+
+        auto const block_result = database_.blocks().get(from);
+
+        if ( ! block_result) {
+            handler(error::not_found, 0, transaction_view{});
+            return;
+        }
+        BITCOIN_ASSERT(block_result.height() == from);
+
+        for (auto const& hash : block_result.transaction_hashes()) {
+            auto const tx_result = tx_store.get(hash, max_size_t, true);
+
+            if ( ! tx_result) {
+                handler(error::operation_failed_16, 0, transaction_view{});
+                return;
+            }
+
+            BITCOIN_ASSERT(tx_result.height() == from);
+            handler(error::success, from, transaction_view(tx_result, witness));
+        }
+
+        ++from;
+    }
+}
+
+void block_chain::for_each_transaction_parallel(size_t from, size_t to, bool witness, bool ordered, for_each_tx_predicate const& handler) const {
+    scan_transactions(from, to, witness, ordered, false, handler);
+}
+
+void block_chain::for_each_transaction_non_coinbase_parallel(size_t from, size_t to, bool witness, bool ordered, for_each_tx_predicate const& handler) const {
+    scan_transactions(from, to, witness, ordered, true, handler);
+}
+
+// private
+void block_chain::scan_transactions(size_t from, size_t to, bool witness, bool ordered, bool skip_coinbase, for_each_tx_predicate const& handler) const {
+#ifdef BITPRIM_CURRENCY_BCH
+    witness = false;
+#endif
+    struct scanned {
+        code ec;
+        chain::transaction::list txs;
+    };
+
+    if (from > to) {
+        return;
+    }
+
+    // Heights above the top are not read, so the range size cannot overflow.
+    size_t top;
+    if ( ! get_last_height(top) || from > top) {
+        handler(error::not_found, from, chain::transaction{});
+        return;
+    }
+
+    to = std::min(to, top);
+    auto const workers = std::min(thread_ceiling(settings_.cores), to - from + 1);
+
+    // Ordered workers do not read more than this many heights past delivery.
+    auto const window = workers * 2;
+
+    std::atomic<size_t> next(from);
+    std::atomic<bool> stop(false);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<size_t, scanned> buffer;
+    auto delivered = from;
+
+    auto const read = [&](size_t height, scanned& out) {
+        if (stopped()) {
+            out.ec = error::service_stopped;
+            return;
+        }
+
+        auto const block_result = database_.blocks().get(height);
+
+        if ( ! block_result) {
+            out.ec = error::not_found;
+            return;
+        }
+
+        BITCOIN_ASSERT(block_result.height() == height);
+        auto const tx_hashes = block_result.transaction_hashes();
+        auto const& tx_store = database_.transactions();
+        auto first = tx_hashes.begin();
+
+        if (skip_coinbase && first != tx_hashes.end()) {
+            ++first;
+        }
+
+        out.txs.reserve(std::distance(first, tx_hashes.end()));
+
+        for (auto it = first; it != tx_hashes.end(); ++it) {
+            auto const tx_result = tx_store.get(*it, max_size_t, true);
+
+            if ( ! tx_result) {
+                out.ec = error::operation_failed_16;
+                return;
+            }
+
+            BITCOIN_ASSERT(tx_result.height() == height);
+            out.txs.push_back(tx_result.transaction(witness));
+        }
+    };
+
+    // Unordered workers deliver concurrently, so each checks for a stop
+    // before every call, none starts a call once the handler returns false.
+    auto const deliver = [&](size_t height, scanned const& block) {
+        for (auto const& tx : block.txs) {
+            if (stop || ! handler(error::success, height, tx)) {
+                return false;
+            }
+        }
+
+        if (stop) {
+            return false;
+        }
+
+        if (block.ec) {
+            handler(block.ec, height, chain::transaction{});
+            return false;
+        }
+
+        return true;
+    };
+
+    auto const work = [&]() {
+        while ( ! stop) {
+            auto const height = next++;
+
+            if (height > to) {
+                return;
+            }
+
+            if (ordered) {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return stop || height < delivered + window; });
+
+                if (stop) {
+                    return;
+                }
+            }
+
+            scanned block;
+            read(height, block);
+
+            if ( ! ordered) {
+                if ( ! deliver(height, block)) {
+                    stop = true;
+                }
+
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffer.emplace(height, std::move(block));
+            }
+
+            changed.notify_all();
+        }
+    };
+
+    // The workers block (ordered) so they are not run on the priority pool,
+    // which block validation (and possibly the handler) requires.
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+
+    for (size_t worker = 0; worker < workers; ++worker) {
+        threads.emplace_back(work);
+    }
+
+    // The reorder buffer is drained in height order on this thread.
+    if (ordered) {
+        auto more = true;
+
+        while (more) {
+            scanned block;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return buffer.count(delivered) != 0; });
+                block = std::move(buffer[delivered]);
+                buffer.erase(delivered);
+            }
+
+            more = deliver(delivered, block) && delivered != to;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = ! more;
+                ++delivered;
+            }
+
+            changed.notify_all();
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void block_chain::fetch_blocks(size_t from, size_t to, bool witness, size_t readahead, block_stream_handler const& handler) const {
+    struct fetched {
+        code ec;
+        block_const_ptr block;
+        size_t height;
+    };
+
+    // The queue bounds the reader, which waits while the handler catches up.
+    auto const capacity = std::max(readahead, size_t(1));
+    std::deque<fetched> queue;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    auto cancelled = false;
+    auto done = false;
+
+    std::thread reader([&]() {
+        for (auto height = from; height <= to; ++height) {
+            std::promise<fetched> promise;
+            fetch_block(height, witness, [&promise, height](code const& ec, block_const_ptr block, size_t) {
+                promise.set_value(fetched{ec, block, height});
+            });
+
+            auto next = promise.get_future().get();
+            auto const failed = bool(next.ec);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_full.wait(lock, [&]() { return cancelled || queue.size() < capacity; });
+
+                if (cancelled) {
+                    return;
+                }
+
+                queue.push_back(std::move(next));
+            }
+
+            not_empty.notify_one();
+
+            // Stop before the increment, which wraps if to is max_size_t.
+            if (failed || height == to) {
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+
+        not_empty.notify_one();
+    });
+
+    while (true) {
+        fetched next;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [&]() { return done || ! queue.empty(); });
+
+            if (queue.empty()) {
+                break;
+            }
+
+            next = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        not_full.notify_one();
+
+        if ( ! handler(next.ec, next.block, next.height) || next.ec) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cancelled = true;
+            }
+
+            not_full.notify_one();
+            break;
+        }
+    }
+
+    reader.join();
+}
+
+size_t block_chain::block_cache_hits() const {
+    return block_cache_.hits();
+}
+
+size_t block_chain::block_cache_misses() const {
+    return block_cache_.misses();
+}
+
+size_t block_chain::extra_transaction_hits() const {
+    return extra_transactions_.hits();
+}
+
+size_t block_chain::extra_transaction_misses() const {
+    return extra_transactions_.misses();
+}
+
 } // namespace blockchain
 } // namespace libbitcoin
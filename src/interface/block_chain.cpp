@@ -21,11 +21,13 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <functional>
 #include <memory>
 #include <numeric>
 #include <string>
 #include <utility>
+#include <unordered_map>
 #include <unordered_set>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/database.hpp>
@@ -70,6 +72,138 @@ using namespace std::placeholders;
 
 static const auto hour_seconds = 3600u;
 
+// Blocks with at least this many transactions are read concurrently.
+static constexpr size_t parallel_read_threshold = 1000;
+
+// Cached blocks carry witness, so are added by and served to witness fetches
+// only (blocks read without witness cannot be served to witness fetches).
+inline
+bool is_cacheable(bool witness)
+{
+#ifdef BITPRIM_CURRENCY_BCH
+    return true;
+#else
+    return witness;
+#endif
+}
+
+// Transactions are stored in wire format with witness. A witness
+// transaction has a marker and flag (in place of an input count) after the
+// version, and its witnesses between the outputs and the locktime.
+static constexpr size_t version_size = sizeof(uint32_t);
+static constexpr size_t locktime_size = sizeof(uint32_t);
+static constexpr size_t point_size = hash_size + sizeof(uint32_t);
+static constexpr size_t sequence_size = sizeof(uint32_t);
+static constexpr size_t value_size = sizeof(uint64_t);
+static constexpr uint8_t witness_marker = 0x00;
+static constexpr uint8_t witness_flag = 0x01;
+
+// Read a variable length integer at the offset, advancing the offset.
+static bool read_variable(const data_slice& data, size_t& offset,
+    uint64_t& out_value)
+{
+    if (offset >= data.size())
+        return false;
+
+    size_t width;
+    const auto prefix = data.begin()[offset++];
+
+    switch (prefix)
+    {
+        case varint_eight_bytes:
+            width = sizeof(uint64_t);
+            break;
+        case varint_four_bytes:
+            width = sizeof(uint32_t);
+            break;
+        case varint_two_bytes:
+            width = sizeof(uint16_t);
+            break;
+        default:
+            out_value = prefix;
+            return true;
+    }
+
+    if (data.size() - offset < width)
+        return false;
+
+    out_value = 0;
+
+    for (size_t byte = 0; byte < width; ++byte)
+        out_value |= uint64_t(data.begin()[offset + byte]) << (byte * 8);
+
+    offset += width;
+    return true;
+}
+
+// Advance the offset past a fixed size field and a length prefixed script.
+static bool skip_scripted(const data_slice& data, size_t& offset,
+    size_t fixed_size, size_t trailing_size)
+{
+    uint64_t size;
+
+    if (data.size() - offset < fixed_size)
+        return false;
+
+    offset += fixed_size;
+
+    if (!read_variable(data, offset, size) ||
+        data.size() - offset < size + trailing_size)
+        return false;
+
+    offset += size + trailing_size;
+    return true;
+}
+
+// Copy the stored transaction, dropping the witness unless it is requested.
+// Only the input and output lengths are read, nothing is deserialized.
+static bool write_transaction(writer& sink, const data_slice& record,
+    bool witness)
+{
+    const auto data = record.begin();
+    const auto size = record.size();
+
+    if (size < version_size + 2u + locktime_size)
+        return false;
+
+    const auto segregated =
+        data[version_size] == witness_marker &&
+        data[version_size + 1u] == witness_flag;
+
+    if (witness || !segregated)
+    {
+        sink.write_bytes(data, size);
+        return true;
+    }
+
+    const auto body = version_size + 2u;
+    auto offset = body;
+    uint64_t count;
+
+    if (!read_variable(record, offset, count))
+        return false;
+
+    for (; count > 0; --count)
+        if (!skip_scripted(record, offset, point_size, sequence_size))
+            return false;
+
+    if (!read_variable(record, offset, count))
+        return false;
+
+    for (; count > 0; --count)
+        if (!skip_scripted(record, offset, value_size, 0))
+            return false;
+
+    if (size - offset < locktime_size)
+        return false;
+
+    // Version, inputs and outputs, then the locktime (witnesses skipped).
+    sink.write_bytes(data, version_size);
+    sink.write_bytes(data + body, offset - body);
+    sink.write_bytes(data + size - locktime_size, locktime_size);
+    return true;
+}
+
 block_chain::block_chain(threadpool& pool,
     const blockchain::settings& chain_settings,
     const database::settings& database_settings,  bool relay_transactions)
@@ -78,20 +212,22 @@ block_chain::block_chain(threadpool& pool,
     notify_limit_seconds_(chain_settings.notify_limit_hours * hour_seconds),
     chain_state_populator_(*this, chain_settings),
     database_(database_settings),
+    block_cache_(chain_settings.block_cache_capacity),
+    extra_transactions_(chain_settings.extra_transaction_capacity),
     validation_mutex_(database_settings.flush_writes && relay_transactions),
     priority_pool_(thread_ceiling(chain_settings.cores),
         priority(chain_settings.priority)),
     dispatch_(priority_pool_, NAME "_priority"),
+    read_pool_(thread_ceiling(chain_settings.cores)),
+    read_dispatch_(read_pool_, NAME "_read"),
     transaction_organizer_(validation_mutex_, dispatch_, pool, *this,
         chain_settings),
     block_organizer_(validation_mutex_, dispatch_, pool, *this, chain_settings,
         relay_transactions),
-    chosen_size_(0),
-    chosen_sigops_(0),
-    chosen_unconfirmed_(),
-    chosen_spent_(),
     gbt_mutex_(),
-    gbt_ready_(true)
+    gbt_merkle_(),
+    gbt_version_(0),
+    gbt_snapshot_(std::make_shared<const gbt_snapshot>())
 {
 }
 
@@ -125,6 +261,9 @@ bool block_chain::get_block_exists_safe(const hash_digest& block_hash) const
 
 bool block_chain::get_block_hash(hash_digest& out_hash, size_t height) const
 {
+    if (header_index_.get_block_hash(out_hash, height))
+        return true;
+
     const auto result = database_.blocks().get(height);
 
     if (!result)
@@ -141,6 +280,10 @@ bool block_chain::get_branch_work(uint256_t& out_work,
     if (!database_.blocks().top(top))
         return false;
 
+    // This is a prefix difference when the index covers through the top.
+    if (header_index_.get_branch_work(out_work, maximum, from_height, top))
+        return true;
+
     out_work = 0;
     for (auto height = from_height; height <= top && out_work < maximum;
         ++height)
@@ -157,6 +300,9 @@ bool block_chain::get_branch_work(uint256_t& out_work,
 
 bool block_chain::get_header(chain::header& out_header, size_t height) const
 {
+    if (header_index_.get_header(out_header, height))
+        return true;
+
     auto result = database_.blocks().get(height);
     if (!result)
         return false;
@@ -178,6 +324,9 @@ bool block_chain::get_height(size_t& out_height,
 
 bool block_chain::get_bits(uint32_t& out_bits, const size_t& height) const
 {
+    if (header_index_.get_bits(out_bits, height))
+        return true;
+
     auto result = database_.blocks().get(height);
     if (!result)
         return false;
@@ -189,6 +338,9 @@ bool block_chain::get_bits(uint32_t& out_bits, const size_t& height) const
 bool block_chain::get_timestamp(uint32_t& out_timestamp,
     const size_t& height) const
 {
+    if (header_index_.get_timestamp(out_timestamp, height))
+        return true;
+
     auto result = database_.blocks().get(height);
     if (!result)
         return false;
@@ -200,6 +352,9 @@ bool block_chain::get_timestamp(uint32_t& out_timestamp,
 bool block_chain::get_version(uint32_t& out_version,
     const size_t& height) const
 {
+    if (header_index_.get_version(out_version, height))
+        return true;
+
     auto result = database_.blocks().get(height);
     if (!result)
         return false;
@@ -287,7 +442,11 @@ bool block_chain::end_insert() const
 
 bool block_chain::insert(block_const_ptr block, size_t height)
 {
-    return database_.insert(*block, height) == error::success;
+    if (database_.insert(*block, height) != error::success)
+        return false;
+
+    index_header(block->header(), height);
+    return true;
 }
 
 void block_chain::push(transaction_const_ptr tx, dispatcher&,
@@ -296,256 +455,252 @@ void block_chain::push(transaction_const_ptr tx, dispatcher&,
     last_transaction_.store(tx);
 
     // Transaction push is currently sequential so dispatch is not used.
-    handler(database_.push(*tx, chain_state()->enabled_forks()));
-}
+    const auto ec = database_.push(*tx, chain_state()->enabled_forks());
 
+    if (!ec)
+        index_unconfirmed(*tx, static_cast<uint32_t>(std::time(nullptr)));
 
-//Mark every previous output of the transaction as TEMPORARY SPENT
-void block_chain::append_spend(transaction_const_ptr tx) {
-    std::vector<prev_output> prev_outputs;
-    for (auto const& input : tx->inputs()) {
-        auto const& output_point = input.previous_output();
-        prev_outputs.push_back({output_point.hash(), output_point.index()});
-    }
-    chosen_spent_.insert({tx->hash(), std::move(prev_outputs)});
-
+    handler(ec);
 }
 
-// Once a transaction was mined, every previous output that was marked
-// as TEMPORARY SPENT, needs to be removed
-// (since it was permanetly added to the spent database)
-void block_chain::remove_spend(libbitcoin::hash_digest const& hash){
-    chosen_spent_.erase(hash);
-}
 
-// Search the TEMPORARY SPENT index for conflicts between previous output
-std::set<libbitcoin::hash_digest> block_chain::get_double_spend_chosen_list(transaction_const_ptr tx) {
+// Check the previous outputs against the store, without deserialization.
+// Each previous transaction must be confirmed or pooled and each previous
+// output must not be spent by a confirmed transaction.
+code block_chain::check_prevouts(transaction_const_ptr tx) const{
+    auto const& tx_store = database_.transactions();
+    auto const& spend_store = database_.spends();
+    auto const& pool = transaction_organizer_.pool();
+    std::unordered_set<hash_digest> found;
 
-    std::set<libbitcoin::hash_digest> spent_conflict{};
-    for (auto const& input : tx->inputs()) {
-        for(auto const& spents : chosen_spent_){
-            for(auto const& previous : spents.second){
-                if(previous.output_hash == input.previous_output().hash() &&
-                    previous.output_index == input.previous_output().index())
-                {
-                    spent_conflict.insert(spents.first);
-                }
-            }
+    for(auto const& input : tx->inputs()){
+        auto const& hash = input.previous_output().hash();
+
+        if (found.find(hash) != found.end()) {
+            continue;
+        }
+
+        if ( ! tx_store.get(hash, max_size_t, true) && ! pool.exists(hash)) {
+            return error::missing_previous_output;
         }
+
+        found.insert(hash);
     }
-    return spent_conflict;
-}
 
-// Search the spent database and the TEMPORARY SPENT for conflicts
-bool block_chain::check_is_double_spend(transaction_const_ptr tx){
-    bool is_double_spend = false;
     for(auto const& input : tx->inputs()){
-        boost::latch latch(2);
-        fetch_spend(input.previous_output(), [&](const libbitcoin::code &ec, libbitcoin::chain::input_point input) {
-            if (ec == libbitcoin::error::success) {
-                is_double_spend = true;
-            }
-            latch.count_down();
-        });
-        latch.count_down_and_wait();
-
-        if(is_double_spend) return true;
+        if (spend_store.get(input.previous_output()).hash() != null_hash) {
+            return error::double_spend;
+        }
     }
-    return !get_double_spend_chosen_list(tx).empty();
+
+    return error::success;
 }
 
+//Add the new transaction to the template engine, with its unconfirmed parents.
+bool block_chain::add_to_chosen_list(transaction_const_ptr tx){
+    //The store is read before adding, it does not depend on the pool
+    auto const ec = check_prevouts(tx);
 
-// Insert to chosen transaction List, ordered by the benefit yielded by the transaction
-bool block_chain::insert_to_chosen_list(transaction_const_ptr& tx, double benefit, size_t tx_size, size_t tx_sigops){
-#ifdef BITPRIM_CURRENCY_BCH
-    tx_benefit txnew{benefit, tx_sigops, tx_size, tx->fees(), tx->to_data(1), tx->hash()};
-#else
-    tx_benefit txnew{benefit, tx_sigops, tx_size, tx->fees(), tx->to_data(1), tx->hash(), tx->hash(true)};
-#endif
-    chosen_unconfirmed_.insert(
-        std::upper_bound(begin(chosen_unconfirmed_), end(chosen_unconfirmed_), txnew, [](tx_benefit const& a, tx_benefit const& b) {
-            return a.benefit < b.benefit;
-    }), txnew);
+    //Unconfirmed parents must have been pooled first and conflicts with the
+    //store are not pooled (first seen wins)
+    if (ec) {
+        return false;
+    }
 
-    chosen_size_ += tx_size;
-    chosen_sigops_ += tx_sigops;
-    append_spend(tx);
+    //A rejected transaction may still have caused the pool to evict
+    hash_list evicted;
+    auto const result = transaction_organizer_.pool().add(tx, evicted);
+    ++gbt_version_;
+    remove_unconfirmed(evicted);
 
-    return true;
+    //A duplicate is already pooled
+    return result == error::success || result == error::unspent_duplicate;
 }
 
-//Search how many transactions we need to remove from the transaction chosen list, if we want to add a new transaction
-size_t block_chain::find_txs_to_remove_from_chosen(const size_t sigops_limit, const size_t tx_size,
-        const size_t tx_sigops, const size_t tx_fees, const double benefit,
-            size_t& acum_sigops, size_t& acum_size, double& acum_benefit)
-{
-    // How many transactions should I remove, while still gaining more benefit
-    acum_benefit += (*chosen_unconfirmed_.begin()).benefit;
-    acum_sigops += (*chosen_unconfirmed_.begin()).tx_sigops;
-    acum_size += (*chosen_unconfirmed_.begin()).tx_size;
+std::vector<block_chain::tx_benefit> block_chain::get_gbt_tx_list() const{
+    if (stopped()) {
+        return std::vector<block_chain::tx_benefit>();
+    }
 
-    size_t removed = 0;
-    auto max_block_size = libbitcoin::get_max_block_size() - libbitcoin::coinbase_reserved_size;
+    auto const snapshot = get_gbt_snapshot();
+    std::vector<tx_benefit> txs_chosen_list;
+    txs_chosen_list.reserve(snapshot->txs.size());
 
-    for(auto to_remove : chosen_unconfirmed_){
-        if(benefit > acum_benefit){
-        //As long as the new transaction generate more benefit than the old ones, keep trying to add to the list
-            if((chosen_sigops_ + tx_sigops - acum_sigops < sigops_limit) &&
-                (chosen_size_ - acum_size + tx_size < (max_block_size))){
-                // If I reached a point where taking out some transaction, i will generate more benefit
-                return 1 + removed;
-            } else {
-                acum_benefit += to_remove.benefit; // Benefit i will loose if i remove this transaction
-                acum_sigops += to_remove.tx_sigops; // Sigops removed from list
-                acum_size += to_remove.tx_size; // Total bytes removed from list
-                removed++;
-            }
-        } else return 0;
+    for (auto const& tx : snapshot->txs) {
+        txs_chosen_list.push_back(*tx);
     }
 
-    return 0;
-
+    return txs_chosen_list;
 }
 
-bool block_chain::get_transaction_is_confirmed(libbitcoin::hash_digest tx_hash){
+// Readers never wait on the selector. If the published snapshot is stale it
+// is rebuilt only when the selector is idle, otherwise the stale (but
+// complete) snapshot is returned.
+block_chain::gbt_snapshot_ptr block_chain::get_gbt_snapshot() const{
+    auto const snapshot = gbt_snapshot_.load();
 
-#ifdef BITPRIM_CURRENCY_BCH
-    bool witness = false;
-#else
-    bool witness = true;
-#endif
+    if (snapshot->version == gbt_version_.load()) {
+        return snapshot;
+    }
 
-    bool is_confirmed = true;
-    boost::latch latch(2);
-    fetch_transaction(tx_hash, true, witness,
-        [&](const libbitcoin::code &ec, libbitcoin::transaction_const_ptr tx_ptr, size_t index,
-                size_t height) {
-        if (ec != libbitcoin::error::success) {
-            is_confirmed = false;
-        }
-        latch.count_down();
-    });
-    latch.count_down_and_wait();
-    return is_confirmed;
+    std::unique_lock<std::mutex> lock(gbt_mutex_, std::try_to_lock);
+
+    if ( ! lock.owns_lock()) {
+        return snapshot;
+    }
 
+    return publish_gbt_snapshot();
 }
 
-//Check if the new transaction can be added to the txs selection.
-bool block_chain::add_to_chosen_list(transaction_const_ptr tx){
-    std::lock_guard<std::mutex> lock(gbt_mutex_);
+// Deltas are combined from the history of the latest snapshot, so this never
+// blocks on the selector. A transaction removed and then added again (or the
+// reverse) within the range is not reported.
+block_chain::gbt_delta block_chain::get_template_delta(size_t since_version) const{
+    auto const snapshot = get_gbt_snapshot();
+    gbt_delta out{since_version, snapshot->version, false, {}, {}};
 
-    //Dont allow dependencies
-    for(auto const& input : tx->inputs()){
-        if( !get_transaction_is_confirmed(input.previous_output().hash())){
-            return false;
-        }
+    if (since_version == snapshot->version) {
+        return out;
     }
 
-    //If is not double spend
-    if (!check_is_double_spend(tx)){
-        auto tx_size = tx->serialized_size(0);
-        auto tx_sigops = tx->signature_operations();
-        auto tx_fees = tx->fees();
+    auto const& history = snapshot->history;
+    auto it = std::find_if(history.begin(), history.end(), [since_version](gbt_change_ptr const& change) {
+        return change->from_version == since_version;
+    });
 
-        auto estimated_size = chosen_size_ + tx_size;
-        auto max_block_size = libbitcoin::get_max_block_size() - libbitcoin::coinbase_reserved_size;
-        auto next_size = (estimated_size > max_block_size)? max_block_size : (estimated_size);
-        auto sigops_limit = (size_t(next_size / libbitcoin::one_million_bytes_block) + 1) * libbitcoin::sigops_per_million_bytes;
-        double benefit = (double(tx_fees) / tx_size );
+    if (it == history.end()) {
+        out.full = true;
+        out.added = snapshot->txs;
+        return out;
+    }
 
-        // Check if the transaction can be added directly to the chosen transaction list
-        if (((chosen_sigops_ + tx_sigops) > sigops_limit) || (estimated_size > max_block_size)){
-            size_t acum_sigops = 0;
-            size_t acum_size = 0;
-            double acum_benefit = 0;
+    std::unordered_set<hash_digest> added;
+    std::unordered_set<hash_digest> removed;
 
-            size_t txs_to_remove_from_list = find_txs_to_remove_from_chosen(sigops_limit, tx_size, tx_sigops, tx_fees, benefit,
-                acum_sigops, acum_size, acum_benefit);
+    for (; it != history.end(); ++it) {
+        for (auto const& hash : (*it)->removed) {
+            if (added.erase(hash) == 0) {
+                removed.insert(hash);
+            }
+        }
 
-            if(txs_to_remove_from_list != 0)
-            {
-                // Remove transactions
-                chosen_sigops_ -= acum_sigops;
-                chosen_size_ -= acum_size;
-                while(txs_to_remove_from_list != 0)
-                {
-                    remove_spend((*chosen_unconfirmed_.begin()).tx_id);
-                    chosen_unconfirmed_.pop_front();
-                    txs_to_remove_from_list--;
-                }
-                // Add the new transaction ordered by benefit
-                insert_to_chosen_list(tx, benefit, tx_size, tx_sigops);
+        for (auto const& hash : (*it)->added) {
+            if (removed.erase(hash) == 0) {
+                added.insert(hash);
             }
-        } else {
-            // Since there still space to add the transaction
-            // Add the new transaction ordered by benefit
-            insert_to_chosen_list(tx, benefit, tx_size, tx_sigops);
         }
     }
 
-    return true;
-} 
-
-std::vector<block_chain::tx_benefit> block_chain::get_gbt_tx_list() const{
-    if (stopped()) {
-        return std::vector<block_chain::tx_benefit>();
+    // Net additions remain chosen, so are taken from the snapshot.
+    out.added.reserve(added.size());
+    for (auto const& tx : snapshot->txs) {
+        if (added.find(tx->tx_id) != added.end()) {
+            out.added.push_back(tx);
+        }
     }
 
-    if (!gbt_ready_) {
-        return std::vector<block_chain::tx_benefit>();
+    out.removed.assign(removed.begin(), removed.end());
+    return out;
+}
+
+// The number of chosen list changes retained for get_template_delta.
+static constexpr size_t gbt_history_size = 64;
+
+// Call only while holding gbt_mutex_. The version is read before selecting,
+// so a concurrent change leaves the snapshot stale rather than lost. Entries
+// of the previous snapshot are shared, so each transaction is serialized
+// once, and the merkle tree rehashes only above the first changed txid.
+block_chain::gbt_snapshot_ptr block_chain::publish_gbt_snapshot() const{
+    auto const snapshot = std::make_shared<gbt_snapshot>();
+    snapshot->version = gbt_version_.load();
+
+    auto const previous = gbt_snapshot_.load();
+    std::unordered_map<hash_digest, tx_benefit_const_ptr> published;
+    published.reserve(previous->txs.size());
+
+    for (auto const& tx : previous->txs) {
+        published.emplace(tx->tx_id, tx);
     }
 
-    std::lock_guard<std::mutex> lock(gbt_mutex_);
-    std::vector<tx_benefit> txs_chosen_list{ std::begin(chosen_unconfirmed_), std::end(chosen_unconfirmed_) };
+    auto const selected = transaction_organizer_.pool().selection();
+    snapshot->txs.reserve(selected.size());
 
-    return txs_chosen_list;
-}
+    auto const change = std::make_shared<gbt_change>();
+    change->from_version = previous->version;
+    change->version = snapshot->version;
 
+    // The coinbase is the first leaf, it is excluded from the branch.
+    hash_list txids;
+    txids.reserve(selected.size() + 1);
+    txids.push_back(null_hash);
 
-//When a new block arrives, we need to check every transaction on the chosen list
-//to see if it was mined; and remove it if it was.
-//using tx_benefit = std::tuple<double /*benefit*/, size_t /*tx_sigops*/, size_t /*tx_size*/, size_t /*tx_fees*/, libbitcoin::data_chunk /*tx_hex*/, libbitcoin::hash_digest /*tx_hash */> ;
-void block_chain::remove_mined_txs_from_chosen_list(block_const_ptr blk){
+    for (auto const& entry : selected) {
+        auto const found = published.find(entry.hash());
 
-    gbt_ready_= false;
-    std::lock_guard<std::mutex> lock(gbt_mutex_);
-    for(auto const& tx : blk->transactions()){
-        //erase transactions by hash
-        auto it = std::find_if (chosen_unconfirmed_.begin(), chosen_unconfirmed_.end(),
-            [&](const tx_benefit& tx_chosen){
-                return tx_chosen.tx_id == tx.hash();
-              });
-        if(it != chosen_unconfirmed_.end()){
-          //If transaction was deleted by hash, remove spended outputs
-          remove_spend(tx.hash());
-          chosen_unconfirmed_.erase(it);
+        if (found != published.end()) {
+            snapshot->txs.push_back(found->second);
+            published.erase(found);
         } else {
-            //If the tx mined hash wasnt on our chosen list
-            //There may be another transaction wich uses the same prev output as this tx. (double spend attempt) 
-            //This should be extremely rare
-            libbitcoin::message::transaction msg_tx {tx};
-            transaction_const_ptr msg_ptr = std::make_shared<const libbitcoin::message::transaction>(msg_tx);
-            for(auto const& conflict_hash : get_double_spend_chosen_list(msg_ptr)){
-                auto conflict = std::find_if (chosen_unconfirmed_.begin(), chosen_unconfirmed_.end(),
-                [&](const tx_benefit& tx_chosen){
-                    return (tx_chosen.tx_id == conflict_hash);
-                  });
-                if(conflict != chosen_unconfirmed_.end()){
-                    chosen_unconfirmed_.erase(conflict);
-                    remove_spend(conflict_hash); //Do it on get_souble_spend_mempool
-                }
-            }
+            auto const tx = entry.transaction();
+            auto const benefit = double(entry.fees()) / entry.size();
+#ifdef BITPRIM_CURRENCY_BCH
+            snapshot->txs.push_back(std::make_shared<const tx_benefit>(tx_benefit{benefit, entry.sigops(), entry.size(), entry.fees(), tx->to_data(1), entry.hash()}));
+#else
+            snapshot->txs.push_back(std::make_shared<const tx_benefit>(tx_benefit{benefit, entry.sigops(), entry.size(), entry.fees(), tx->to_data(1), entry.hash(), tx->hash(true)}));
+#endif
+            change->added.push_back(entry.hash());
         }
+
+        txids.push_back(entry.hash());
+    }
+
+    // Entries of the previous snapshot that were not selected again.
+    for (auto const& tx : published) {
+        change->removed.push_back(tx.first);
     }
 
-    chosen_size_ = 0;
-    chosen_sigops_ = 0;
-    for(auto const& tx : chosen_unconfirmed_ ){
-        chosen_sigops_ += tx.tx_sigops;
-        chosen_size_ += tx.tx_size;
+    auto const& history = previous->history;
+    auto const retained = std::min(history.size(), gbt_history_size - 1);
+    snapshot->history.reserve(retained + 1);
+    snapshot->history.assign(history.end() - retained, history.end());
+    snapshot->history.push_back(change);
+
+    gbt_merkle_.update(txids);
+    snapshot->merkle_branch = gbt_merkle_.branch();
+
+    // A version change need not change the chosen list (or its order).
+    if (previous->payload && snapshot->txs == previous->txs) {
+        snapshot->payload = previous->payload;
+    } else {
+        size_t payload_size = 0;
+        for (auto const& tx : snapshot->txs) {
+            payload_size += tx->tx_hex.size();
+        }
+
+        auto const payload = std::make_shared<data_chunk>();
+        payload->reserve(payload_size);
+
+        for (auto const& tx : snapshot->txs) {
+            payload->insert(payload->end(), tx->tx_hex.begin(), tx->tx_hex.end());
+        }
+
+        snapshot->payload = payload;
     }
-    gbt_ready_ = true;
 
+    gbt_snapshot_.store(snapshot);
+    return snapshot;
+}
+
+
+//When a new block arrives, the mined transactions leave the pool (anchoring
+//their pooled children) and pooled conflicts are removed with descendants.
+void block_chain::remove_mined_txs_from_chosen_list(block_const_ptr blk){
+    transaction_organizer_.pool().remove(blk);
+    ++gbt_version_;
+
+    // Publish now, the template is most requested right after a block.
+    std::lock_guard<std::mutex> lock(gbt_mutex_);
+    publish_gbt_snapshot();
 }
 
 void block_chain::fetch_unconfirmed_transaction(const hash_digest& hash, 
@@ -585,14 +740,23 @@ void block_chain::reorganize(const checkpoint& fork_point,
     // The top (back) block is used to update the chain state.
     const auto complete =
         std::bind(&block_chain::handle_reorganize,
-            this, _1, incoming_blocks->back(), handler);
+            this, _1, fork_point.height(), incoming_blocks, outgoing_blocks,
+            handler);
+
+    // Drop the outgoing heights before the store changes, so that the index
+    // remains a prefix of the store while it is written (common to both the
+    // outgoing and incoming chains). Heights above it are read from the store.
+    // This runs under the organizer's high priority lock and the incoming
+    // heights are indexed before that lock is released.
+    header_index_.pop_above(fork_point.height());
 
     database_.reorganize(fork_point, incoming_blocks, outgoing_blocks,
         dispatch, complete);
 }
 
-void block_chain::handle_reorganize(const code& ec, block_const_ptr top,
-    result_handler handler)
+void block_chain::handle_reorganize(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming_blocks,
+    block_const_ptr_list_ptr outgoing_blocks, result_handler handler)
 {
     if (ec)
     {
@@ -600,6 +764,26 @@ void block_chain::handle_reorganize(const code& ec, block_const_ptr top,
         return;
     }
 
+    for (const auto block: *outgoing_blocks)
+        block_cache_.remove(block->hash());
+
+    auto height = fork_height;
+
+    for (const auto block: *incoming_blocks)
+    {
+        index_header(block->header(), ++height);
+        block_cache_.add(block, height);
+
+        // Confirmed transactions leave the unconfirmed table.
+        for (const auto& tx: block->transactions())
+        {
+            mempool_address_index_.remove(tx.hash());
+            short_id_table_.remove(tx.hash());
+        }
+    }
+
+    const auto top = incoming_blocks->back();
+
     if (!top->validation.state)
     {
         handler(error::operation_failed_14);
@@ -649,6 +833,303 @@ code block_chain::set_chain_state(chain::chain_state::ptr previous)
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// private.
+// Transactions of large blocks are read from the store concurrently on the
+// read pool, each bucket reading a stride of positions into the list. The
+// reads are joined before the handler is invoked, so the read is synchronous.
+void block_chain::read_block(const chain::header& header,
+    const hash_list& tx_hashes, size_t height, size_t generation, bool witness,
+    const code& failure, block_fetch_handler handler) const
+{
+    const auto count = tx_hashes.size();
+    const auto buckets = std::min(read_dispatch_.size(), count);
+    transaction::list txs(count);
+    code ec;
+
+    if (count >= parallel_read_threshold && buckets > 1)
+    {
+        std::vector<code> codes(buckets);
+        boost::latch latch(buckets);
+
+        for (size_t bucket = 0; bucket < buckets; ++bucket)
+            read_dispatch_.concurrent([&, bucket]()
+            {
+                codes[bucket] = read_transactions(tx_hashes, txs, height,
+                    witness, failure, bucket, buckets);
+                latch.count_down();
+            });
+
+        latch.wait();
+        const auto failed = std::find_if(codes.begin(), codes.end(),
+            [](const code& value) { return value != error::success; });
+
+        if (failed != codes.end())
+            ec = *failed;
+    }
+    else
+    {
+        ec = read_transactions(tx_hashes, txs, height, witness, failure, 0, 1);
+    }
+
+    if (ec)
+    {
+        handler(ec, nullptr, 0);
+        return;
+    }
+
+    const auto message = std::make_shared<const block>(header, std::move(txs));
+
+    if (is_cacheable(witness))
+        block_cache_.add(message, height, generation);
+
+    handler(error::success, message, height);
+}
+
+// private.
+// Read every bucket-th transaction of the block, starting at the bucket.
+code block_chain::read_transactions(const hash_list& tx_hashes,
+    transaction::list& txs, size_t height, bool witness, const code& failure,
+    size_t bucket, size_t buckets) const
+{
+    const auto& tx_store = database_.transactions();
+    const auto count = tx_hashes.size();
+
+    for (auto position = bucket; position < count;
+        position = ceiling_add(position, buckets))
+    {
+        if (stopped())
+            return error::service_stopped;
+
+        const auto tx_result = tx_store.get(tx_hashes[position], max_size_t,
+            true);
+
+        if (!tx_result)
+            return failure;
+
+        BITCOIN_ASSERT(tx_result.height() == height);
+        BITCOIN_ASSERT(tx_result.position() == position);
+        txs[position] = tx_result.transaction(witness);
+    }
+
+    return error::success;
+}
+
+// private.
+// Write the header, transaction count and transactions into a single buffer,
+// copying each transaction from its stored record.
+bool block_chain::read_block_raw(data_chunk& out_data,
+    const database::block_result& result, bool witness) const
+{
+    const auto tx_hashes = result.transaction_hashes();
+    const auto& tx_store = database_.transactions();
+
+    out_data.clear();
+    out_data.reserve(result.serialized_size());
+    data_sink ostream(out_data);
+    ostream_writer sink(ostream);
+
+    result.header().to_data(sink);
+    sink.write_variable_little_endian(tx_hashes.size());
+    DEBUG_ONLY(size_t position = 0;)
+
+    for (const auto& hash: tx_hashes)
+    {
+        const auto tx_result = tx_store.get(hash, max_size_t, true);
+
+        if (!tx_result)
+            return false;
+
+        BITCOIN_ASSERT(tx_result.height() == result.height());
+        BITCOIN_ASSERT(tx_result.position() == position++);
+
+        if (!write_transaction(sink, tx_result.data(), witness))
+            return false;
+    }
+
+    ostream.flush();
+    return true;
+}
+
+// private.
+void block_chain::build_header_index()
+{
+    size_t top;
+    header_index_.clear();
+
+    if (!database_.blocks().top(top))
+        return;
+
+    header_index_.reserve(safe_add(top, size_t(1)));
+
+    // Stop at the first gap, heights above the index are read from the store.
+    for (size_t height = 0; height <= top; ++height)
+    {
+        const auto result = database_.blocks().get(height);
+
+        if (!result || !header_index_.push(result.header(), height))
+            break;
+    }
+}
+
+// private.
+// Blocks may be stored out of order (parallel IBD), so the index is extended
+// from the store across any heights stored since it last advanced.
+void block_chain::index_header(const chain::header& header, size_t height)
+{
+    // Backfill heights stored below this one, a remaining gap defers indexing.
+    for (auto next = header_index_.size(); next < height; ++next)
+    {
+        const auto result = database_.blocks().get(next);
+
+        if (!result || !header_index_.push(result.header(), next))
+            return;
+    }
+
+    if (!header_index_.push(header, height))
+    {
+        // A concurrent insert may have filled this height from the store.
+        hash_digest indexed;
+        if (header_index_.get_block_hash(indexed, height) &&
+            indexed == header.hash())
+            return;
+
+        LOG_FATAL(LOG_BLOCKCHAIN)
+            << "Header index out of step with the store at height " << height
+            << ", index size " << header_index_.size();
+        BITCOIN_ASSERT_MSG(false, "header index not contiguous");
+        return;
+    }
+
+    // Forward fill heights stored above this one before it arrived.
+    for (auto next = safe_add(height, size_t(1)); ; ++next)
+    {
+        const auto result = database_.blocks().get(next);
+
+        if (!result || !header_index_.push(result.header(), next))
+            return;
+    }
+}
+
+// private.
+// The unconfirmed table persists across restarts, so the pool and its indexes
+// are rebuilt from it on start. Parents are pooled before their children.
+void block_chain::build_mempool_index()
+{
+    typedef std::pair<transaction_const_ptr, uint32_t> unconfirmed;
+    std::unordered_map<hash_digest, unconfirmed> stored;
+
+    mempool_address_index_.clear();
+    short_id_table_.clear();
+
+    database_.transactions_unconfirmed().for_each_result(
+        [&stored](const database::transaction_unconfirmed_result& result)
+        {
+            const auto tx = std::make_shared<const transaction>(
+                result.transaction());
+            stored.emplace(tx->hash(), unconfirmed{ tx, result.arrival_time() });
+            return true;
+        });
+
+    hash_list removed;
+    std::unordered_set<hash_digest> visited;
+    std::function<void(const unconfirmed&)> pool_unconfirmed;
+
+    pool_unconfirmed = [&](const unconfirmed& value)
+    {
+        const auto& tx = value.first;
+
+        if (!visited.insert(tx->hash()).second)
+            return;
+
+        // Fees are computed from the previous output caches.
+        for (const auto& input: tx->inputs())
+        {
+            const auto& prevout = input.previous_output();
+            const auto parent = stored.find(prevout.hash());
+
+            if (parent != stored.end())
+            {
+                pool_unconfirmed(parent->second);
+                const auto& outputs = parent->second.first->outputs();
+
+                if (prevout.index() < outputs.size())
+                    prevout.validation.cache = outputs[prevout.index()];
+
+                continue;
+            }
+
+            const auto result = database_.transactions().get(prevout.hash(),
+                max_size_t, false);
+
+            if (result)
+                prevout.validation.cache = result.output(prevout.index());
+        }
+
+        auto ec = check_prevouts(tx);
+
+        if (!ec)
+            ec = transaction_organizer_.pool().add(tx, removed);
+
+        // Transactions conflicted while stopped or evicted are not restored.
+        if (ec && ec != error::unspent_duplicate)
+        {
+            removed.push_back(tx->hash());
+            return;
+        }
+
+        index_unconfirmed(*tx, value.second);
+    };
+
+    for (const auto& entry: stored)
+        pool_unconfirmed(entry.second);
+
+    remove_unconfirmed(removed);
+}
+
+// private.
+// Transactions leaving the pool are no longer served as unconfirmed.
+void block_chain::remove_unconfirmed(const hash_list& hashes)
+{
+    for (const auto& hash: hashes)
+    {
+        mempool_address_index_.remove(hash);
+        short_id_table_.remove(hash);
+        database_.transactions_unconfirmed().unlink_if_exists(hash);
+    }
+}
+
+void block_chain::index_unconfirmed(const chain::transaction& tx,
+    uint32_t timestamp)
+{
+    chain::output::list prevouts;
+    prevouts.reserve(tx.inputs().size());
+
+    for (const auto& input: tx.inputs())
+    {
+        const auto& prevout = input.previous_output();
+
+        if (prevout.validation.cache.is_valid())
+        {
+            prevouts.push_back(prevout.validation.cache);
+            continue;
+        }
+
+        const auto result = database_.transactions().get(prevout.hash(),
+            max_size_t, false);
+
+        prevouts.push_back(result ? result.output(prevout.index()) :
+            chain::output{});
+    }
+
+    mempool_address_index_.add(tx, prevouts, timestamp);
+
+#ifdef BITPRIM_CURRENCY_BCH
+    short_id_table_.add(tx.hash(), tx.hash());
+#else
+    short_id_table_.add(tx.hash(), tx.hash(true));
+#endif
+}
+
 // ============================================================================
 // SAFE CHAIN
 // ============================================================================
@@ -663,6 +1144,10 @@ bool block_chain::start()
     if (!database_.open())
         return false;
 
+    // Index headers after database start but before chain state population.
+    build_header_index();
+    build_mempool_index();
+
     // Initialize chain state after database start but before organizers.
     pool_state_ = chain_state_populator_.populate();
 
@@ -674,12 +1159,16 @@ bool block_chain::stop()
 {
     stopped_ = true;
 
+    // Queued transaction pushes wait on the low priority lock, so they are
+    // drained before the high priority lock is taken.
+    auto result = transaction_organizer_.stop();
+
     // Critical Section
     ///////////////////////////////////////////////////////////////////////////
     validation_mutex_.lock_high_priority();
 
     // This cannot call organize or stop (lock safe).
-    auto result = transaction_organizer_.stop() && block_organizer_.stop();
+    result = block_organizer_.stop() && result;
 
     // The priority pool must not be stopped while organizing.
     priority_pool_.shutdown();
@@ -695,6 +1184,10 @@ bool block_chain::close()
 {
     const auto result = stop();
     priority_pool_.join();
+
+    // Reads check for stop, so any in progress return before the join.
+    read_pool_.shutdown();
+    read_pool_.join();
     return result && database_.close();
 }
 
@@ -720,49 +1213,39 @@ void block_chain::fetch_block(size_t height, bool witness,
         return;
     }
 
+    const auto cacheable = is_cacheable(witness);
     const auto cached = last_block_.load();
 
     // Try the cached block first.
-    if (cached && cached->validation.state &&
+    if (cacheable && cached && cached->validation.state &&
         cached->validation.state->height() == height)
     {
         handler(error::success, cached, height);
         return;
     }
 
-    const auto block_result = database_.blocks().get(height);
+    const auto recent = cacheable ? block_cache_.get(height) : nullptr;
 
-    if (!block_result)
+    if (recent)
     {
-        handler(error::not_found, nullptr, 0);
+        handler(error::success, recent, height);
         return;
     }
 
-    BITCOIN_ASSERT(block_result.height() == height);
-    const auto tx_hashes = block_result.transaction_hashes();
-    const auto& tx_store = database_.transactions();
-    transaction::list txs;
-    txs.reserve(tx_hashes.size());
-    DEBUG_ONLY(size_t position = 0;)
+    // Read before the store so that a block reorganized out during the read
+    // is not cached.
+    const auto generation = block_cache_.generation();
+    const auto block_result = database_.blocks().get(height);
 
-    for (const auto& hash: tx_hashes)
+    if (!block_result)
     {
-        const auto tx_result = tx_store.get(hash, max_size_t, true);
-
-        if (!tx_result)
-        {
-            handler(error::operation_failed_16, nullptr, 0);
-            return;
-        }
-
-        BITCOIN_ASSERT(tx_result.height() == height);
-        BITCOIN_ASSERT(tx_result.position() == position++);
-        txs.push_back(tx_result.transaction(witness));
+        handler(error::not_found, nullptr, 0);
+        return;
     }
 
-    auto message = std::make_shared<const block>(block_result.header(),
-        std::move(txs));
-    handler(error::success, message, height);
+    BITCOIN_ASSERT(block_result.height() == height);
+    read_block(block_result.header(), block_result.transaction_hashes(),
+        height, generation, witness, error::operation_failed_16, handler);
 }
 
 void block_chain::fetch_block(const hash_digest& hash, bool witness,
@@ -777,15 +1260,30 @@ void block_chain::fetch_block(const hash_digest& hash, bool witness,
         return;
     }
 
+    const auto cacheable = is_cacheable(witness);
     const auto cached = last_block_.load();
 
     // Try the cached block first.
-    if (cached && cached->validation.state && cached->hash() == hash)
+    if (cacheable && cached && cached->validation.state &&
+        cached->hash() == hash)
     {
         handler(error::success, cached, cached->validation.state->height());
         return;
     }
 
+    size_t recent_height;
+    const auto recent = cacheable ?
+        block_cache_.get(recent_height, hash) : nullptr;
+
+    if (recent)
+    {
+        handler(error::success, recent, recent_height);
+        return;
+    }
+
+    // Read before the store so that a block reorganized out during the read
+    // is not cached.
+    const auto generation = block_cache_.generation();
     const auto block_result = database_.blocks().get(hash);
 
     if (!block_result)
@@ -794,31 +1292,91 @@ void block_chain::fetch_block(const hash_digest& hash, bool witness,
         return;
     }
 
-    const auto height = block_result.height();
-    const auto tx_hashes = block_result.transaction_hashes();
-    const auto& tx_store = database_.transactions();
-    transaction::list txs;
-    txs.reserve(tx_hashes.size());
-    DEBUG_ONLY(size_t position = 0;)
+    read_block(block_result.header(), block_result.transaction_hashes(),
+        block_result.height(), generation, witness, error::operation_failed_17,
+        handler);
+}
 
-    for (const auto& hash: tx_hashes)
+void block_chain::fetch_block_raw(size_t height, bool witness,
+    block_raw_fetch_handler handler) const
+{
+#ifdef BITPRIM_CURRENCY_BCH
+    witness = false;
+#endif
+    if (stopped())
     {
-        const auto tx_result = tx_store.get(hash, max_size_t, true);
+        handler(error::service_stopped, {}, 0);
+        return;
+    }
 
-        if (!tx_result)
-        {
-            handler(error::operation_failed_17, nullptr, 0);
-            return;
-        }
+    // Cached blocks are serialized directly, there is no store read.
+    const auto cached = block_cache_.get(height);
 
-        BITCOIN_ASSERT(tx_result.height() == height);
-        BITCOIN_ASSERT(tx_result.position() == position++);
-        txs.push_back(tx_result.transaction(witness));
+    if (cached)
+    {
+        handler(error::success, cached->to_data(witness), height);
+        return;
     }
 
-    const auto message = std::make_shared<const block>(block_result.header(),
-        std::move(txs));
-    handler(error::success, message, height);
+    const auto block_result = database_.blocks().get(height);
+
+    if (!block_result)
+    {
+        handler(error::not_found, {}, 0);
+        return;
+    }
+
+    BITCOIN_ASSERT(block_result.height() == height);
+    data_chunk data;
+
+    if (!read_block_raw(data, block_result, witness))
+    {
+        handler(error::operation_failed_16, {}, 0);
+        return;
+    }
+
+    handler(error::success, data, height);
+}
+
+void block_chain::fetch_block_raw(const hash_digest& hash, bool witness,
+    block_raw_fetch_handler handler) const
+{
+#ifdef BITPRIM_CURRENCY_BCH
+    witness = false;
+#endif
+    if (stopped())
+    {
+        handler(error::service_stopped, {}, 0);
+        return;
+    }
+
+    // Cached blocks are serialized directly, there is no store read.
+    size_t cached_height;
+    const auto cached = block_cache_.get(cached_height, hash);
+
+    if (cached)
+    {
+        handler(error::success, cached->to_data(witness), cached_height);
+        return;
+    }
+
+    const auto block_result = database_.blocks().get(hash);
+
+    if (!block_result)
+    {
+        handler(error::not_found, {}, 0);
+        return;
+    }
+
+    data_chunk data;
+
+    if (!read_block_raw(data, block_result, witness))
+    {
+        handler(error::operation_failed_17, {}, 0);
+        return;
+    }
+
+    handler(error::success, data, block_result.height());
 }
 
 void block_chain::fetch_block_header_txs_size(const hash_digest& hash,
@@ -972,7 +1530,8 @@ void block_chain::fetch_compact_block(const hash_digest& hash, compact_block_fet
         return;
     }
     
-    fetch_block(hash, witness,[&handler](const code& ec, block_const_ptr message, size_t height) {
+    // The handler is captured by value since the fetch may complete async.
+    fetch_block(hash, witness,[handler](const code& ec, block_const_ptr message, size_t height) {
             
         if (ec == error::success) {
             auto blk_ptr = std::make_shared<compact_block>(compact_block::factory_from_block(*message));
@@ -1133,52 +1692,28 @@ std::vector<libbitcoin::blockchain::mempool_transaction_summary> block_chain::ge
         }
     }
 
-    database_.transactions_unconfirmed().for_each_result([&](libbitcoin::database::transaction_unconfirmed_result const &tx_res) {
-        auto tx = tx_res.transaction(witness);
-        tx.recompute_hash();
-        size_t i = 0;
-        for (auto const& output : tx.outputs()) {
-            const auto tx_addresses = libbitcoin::wallet::payment_address::extract(output.script(), encoding_p2kh, encoding_p2sh);
-            for(const auto tx_address : tx_addresses) {
-                if (tx_address && addrs.find(tx_address) != addrs.end()) {
-                    ret.push_back
-                            (libbitcoin::blockchain::mempool_transaction_summary
-                                     (tx_address.encoded(), libbitcoin::encode_hash(tx.hash()), "",
-                                      "", std::to_string(output.value()), i, tx_res.arrival_time()));
-                }
-            }
-            ++i;
-        }
-        i = 0;
-        for (auto const& input : tx.inputs()) {
-            // TODO: payment_addrress::extract should use the prev_output script instead of the input script
-            // see https://github.com/bitprim/bitprim-core/blob/v0.10.0/src/wallet/payment_address.cpp#L505
-            const auto tx_addresses = libbitcoin::wallet::payment_address::extract(input.script(), encoding_p2kh, encoding_p2sh);
-            for(const auto tx_address : tx_addresses)
-            if (tx_address && addrs.find(tx_address) != addrs.end()) {
-                boost::latch latch(2);
-                fetch_transaction(input.previous_output().hash(), false, witness,
-                                  [&](const libbitcoin::code &ec,
-                                      libbitcoin::transaction_const_ptr tx_ptr, size_t index,
-                                      size_t height) {
-                                      if (ec == libbitcoin::error::success) {
-                                          ret.push_back(libbitcoin::blockchain::mempool_transaction_summary
-                                                                (tx_address.encoded(),
-                                                                libbitcoin::encode_hash(tx.hash()),
-                                                                libbitcoin::encode_hash(input.previous_output().hash()),
-                                                                 std::to_string(input.previous_output().index()),
-                                                                "-"+std::to_string(tx_ptr->outputs()[input.previous_output().index()].value()),
-                                                                i,
-                                                                tx_res.arrival_time()));
-                                      }
-                                      latch.count_down();
-                                  });
-                latch.count_down_and_wait();
+    for (auto const& address : addrs) {
+        auto const encoding = address.version() == libbitcoin::wallet::payment_address::mainnet_p2sh ||
+            address.version() == libbitcoin::wallet::payment_address::testnet_p2sh ? encoding_p2sh : encoding_p2kh;
+        auto const encoded = libbitcoin::wallet::payment_address(address.hash(), encoding).encoded();
+
+        for (auto const& row : mempool_address_index_.get(address)) {
+            if (row.spend) {
+                ret.push_back(libbitcoin::blockchain::mempool_transaction_summary
+                                      (encoded,
+                                       libbitcoin::encode_hash(row.hash),
+                                       libbitcoin::encode_hash(row.previous_output.hash()),
+                                       std::to_string(row.previous_output.index()),
+                                       "-" + std::to_string(row.value),
+                                       row.index,
+                                       row.timestamp));
+            } else {
+                ret.push_back(libbitcoin::blockchain::mempool_transaction_summary
+                                      (encoded, libbitcoin::encode_hash(row.hash), "",
+                                       "", std::to_string(row.value), row.index, row.timestamp));
             }
-            ++i;
         }
-        return true;
-    });
+    }
 
     return ret;
 }
@@ -1194,63 +1729,39 @@ std::vector<libbitcoin::blockchain::mempool_transaction_summary> block_chain::ge
 */
 
 
+// Short ids are resolved against the short id table in one pass, so only the
+// matched transactions are read from the unconfirmed table.
 void block_chain::fill_tx_list_from_mempool(message::compact_block const& block, size_t& mempool_count, std::vector<chain::transaction>& txn_available, std::unordered_map<uint64_t, uint16_t> const& shorttxids) const {
-    
-    std::vector<bool> have_txn(txn_available.size());
-    
+#ifdef BITPRIM_CURRENCY_BCH
+    bool witness = false;
+#else
+    bool witness = true;
+#endif
+
     auto header_hash = hash(block);
     auto k0 = from_little_endian_unsafe<uint64_t>(header_hash.begin());
     auto k1 = from_little_endian_unsafe<uint64_t>(header_hash.begin() + sizeof(uint64_t));
 
-        
-    //LOG_INFO(LOG_BLOCKCHAIN)
-    //<< "fill_tx_list_from_mempool header_hash ->  " << encode_hash(header_hash) 
-    //<< " k0 " << k0
-    //<< " k1 " << k1;
-            
+    hash_list txids(txn_available.size(), null_hash);
+    short_id_table_.resolve(txids, k0, k1, shorttxids);
 
-    database_.transactions_unconfirmed().for_each([&](chain::transaction const &tx) {
-#ifdef BITPRIM_CURRENCY_BCH
-        bool witness = false;
-#else
-        bool witness = true;
-#endif
-        uint64_t shortid = sip_hash_uint256(k0, k1, tx.hash(witness)) & uint64_t(0xffffffffffff);
-        
-      /*   LOG_INFO(LOG_BLOCKCHAIN)
-            << "mempool tx ->  " << encode_hash(tx.hash()) 
-            << " shortid " << shortid;
-      */      
-        auto idit = shorttxids.find(shortid);
-        if (idit != shorttxids.end()) {
-            if (!have_txn[idit->second]) {
-                txn_available[idit->second] = tx;
-                have_txn[idit->second] = true;
-                ++mempool_count;
-            } else {
-                // If we find two mempool txn that match the short id, just
-                // request it. This should be rare enough that the extra
-                // bandwidth doesn't matter, but eating a round-trip due to
-                // FillBlock failure would be annoying.
-                if (txn_available[idit->second].is_valid()) {
-                    //txn_available[idit->second].reset();
-                    txn_available[idit->second] = chain::transaction{};
-                    --mempool_count;
-                }
-            }
-        }
-        // Though ideally we'd continue scanning for the
-        // two-txn-match-shortid case, the performance win of an early exit
-        // here is too good to pass up and worth the extra risk.
-        if (mempool_count == shorttxids.size()) {
-            return false;
-        } else {
-            return true;
+    for (size_t slot = 0; slot < txids.size(); ++slot) {
+        if (txids[slot] == null_hash) {
+            continue;
         }
-    });
-}
 
+        // The transaction may have been confirmed since it was resolved.
+        auto const result = database_.transactions_unconfirmed().get(txids[slot]);
 
+        if (result) {
+            txn_available[slot] = result.transaction(witness);
+            ++mempool_count;
+        }
+    }
+
+    // Recently seen transactions that are not pooled may also be mined.
+    extra_transactions_.fill(txn_available, mempool_count, k0, k1, shorttxids);
+}
 
 safe_chain::mempool_mini_hash_map block_chain::get_mempool_mini_hash_map(message::compact_block const& block) const {
 #ifdef BITPRIM_CURRENCY_BCH
@@ -1269,22 +1780,20 @@ safe_chain::mempool_mini_hash_map block_chain::get_mempool_mini_hash_map(message
     auto k1 = from_little_endian_unsafe<uint64_t>(header_hash.begin() + sizeof(uint64_t));
 
     safe_chain::mempool_mini_hash_map mempool;
-   
-    database_.transactions_unconfirmed().for_each([&](chain::transaction const &tx) {
-    
-        auto sh = sip_hash_uint256(k0, k1, tx.hash(witness));
-        
-       /* to_little_endian()
-        uint64_t pepe = 4564564;
-        uint64_t pepe2 = pepe & 0x0000ffffffffffff;
-            
-        reinterpret_cast<uint8_t*>(pepe2);
-        */
-        //Drop the most significative bytes from the sh
+
+    for (auto const& entry : short_id_table_.short_ids(k0, k1)) {
+        auto const result = database_.transactions_unconfirmed().get(entry.second);
+
+        if ( ! result) {
+            continue;
+        }
+
+        //Keep the least significant 6 bytes of the short id
+        auto const bytes = to_little_endian(entry.first);
         mini_hash short_id;
-        mempool.emplace(short_id,tx);
-        return true;
-    });
+        std::copy_n(bytes.begin(), short_id.size(), short_id.begin());
+        mempool.emplace(short_id, result.transaction(witness));
+    }
 
     return mempool;
 }
@@ -1583,7 +2092,7 @@ void block_chain::fetch_template(merkle_block_fetch_handler handler) const
 void block_chain::fetch_mempool(size_t count_limit, uint64_t minimum_fee,
     inventory_fetch_handler handler) const
 {
-    transaction_organizer_.fetch_mempool(count_limit, handler);
+    transaction_organizer_.fetch_mempool(count_limit, minimum_fee, handler);
 }
 
 // Filters.
@@ -1680,8 +2189,18 @@ void block_chain::organize(block_const_ptr block, result_handler handler)
 
 void block_chain::organize(transaction_const_ptr tx, result_handler handler)
 {
+    // Rejected (and orphan) transactions may yet be mined, so are retained
+    // for compact block reconstruction.
+    const auto complete = [this, tx, handler](const code& ec)
+    {
+        if (ec && ec != error::service_stopped)
+            extra_transactions_.add(tx);
+
+        handler(ec);
+    };
+
     // This cannot call organize or stop (lock safe).
-    transaction_organizer_.organize(tx, handler);
+    transaction_organizer_.organize(tx, complete);
 }
 
 
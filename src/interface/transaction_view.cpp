@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/interface/transaction_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/database.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+transaction_view::transaction_view()
+  : result_(nullptr), witness_(false)
+{
+}
+
+transaction_view::transaction_view(const database::transaction_result& result,
+    bool witness)
+  : result_(&result), witness_(witness)
+{
+}
+
+transaction_view::operator bool() const
+{
+    return result_ != nullptr;
+}
+
+const hash_digest& transaction_view::hash() const
+{
+    BITCOIN_ASSERT(result_ != nullptr);
+    return result_->hash();
+}
+
+size_t transaction_view::height() const
+{
+    BITCOIN_ASSERT(result_ != nullptr);
+    return result_->height();
+}
+
+size_t transaction_view::position() const
+{
+    BITCOIN_ASSERT(result_ != nullptr);
+    return result_->position();
+}
+
+chain::output transaction_view::output(uint32_t index) const
+{
+    BITCOIN_ASSERT(result_ != nullptr);
+    return result_->output(index);
+}
+
+chain::transaction transaction_view::transaction() const
+{
+    BITCOIN_ASSERT(result_ != nullptr);
+    return result_->transaction(witness_);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
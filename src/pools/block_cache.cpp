@@ -0,0 +1,227 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/block_cache.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+block_cache::block_cache(size_t capacity)
+  : capacity_(capacity),
+    hits_(0),
+    misses_(0),
+    bytes_(0),
+    generation_(0)
+{
+}
+
+size_t block_cache::capacity() const
+{
+    return capacity_;
+}
+
+size_t block_cache::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_cache::bytes() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return bytes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t block_cache::hits() const
+{
+    return hits_.load();
+}
+
+size_t block_cache::misses() const
+{
+    return misses_.load();
+}
+
+size_t block_cache::generation() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return generation_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::add(block_const_ptr block, size_t height)
+{
+    if (capacity_ == 0)
+        return;
+
+    const auto size = block->serialized_size(true);
+
+    // A block that cannot fit would flush the cache without being retained.
+    if (size > capacity_)
+        return;
+
+    const auto hash = block->hash();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    insert(block, hash, height, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::add(block_const_ptr block, size_t height,
+    size_t generation)
+{
+    if (capacity_ == 0)
+        return;
+
+    const auto size = block->serialized_size(true);
+
+    if (size > capacity_)
+        return;
+
+    const auto hash = block->hash();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // The removal of a reorganized block must not be undone by a read of it
+    // that began before the removal.
+    if (generation == generation_)
+        insert(block, hash, height, size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::remove(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    ++generation_;
+
+    const auto it = hashes_.find(hash);
+    if (it != hashes_.end())
+        erase(it->second);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void block_cache::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    ++generation_;
+    hashes_.clear();
+    heights_.clear();
+    entries_.clear();
+    bytes_ = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+block_const_ptr block_cache::get(size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = heights_.find(height);
+    if (it == heights_.end())
+    {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    touch(it->second);
+    return it->second->block;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+block_const_ptr block_cache::get(size_t& out_height,
+    const hash_digest& hash) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = hashes_.find(hash);
+    if (it == hashes_.end())
+    {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    touch(it->second);
+    out_height = it->second->height;
+    return it->second->block;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private, call only from within a unique lock.
+void block_cache::insert(block_const_ptr block, const hash_digest& hash,
+    size_t height, size_t size)
+{
+    const auto by_hash = hashes_.find(hash);
+    if (by_hash != hashes_.end())
+        erase(by_hash->second);
+
+    const auto by_height = heights_.find(height);
+    if (by_height != heights_.end())
+        erase(by_height->second);
+
+    entries_.push_front(entry{ block, hash, height, size });
+    hashes_.emplace(hash, entries_.begin());
+    heights_.emplace(height, entries_.begin());
+    bytes_ += size;
+
+    while (bytes_ > capacity_)
+        erase(std::prev(entries_.end()));
+}
+
+// private, call only from within a unique lock.
+void block_cache::erase(iterator it)
+{
+    hashes_.erase(it->hash);
+    heights_.erase(it->height);
+    bytes_ -= it->size;
+    entries_.erase(it);
+}
+
+// private, call only from within a unique lock.
+void block_cache::touch(iterator it) const
+{
+    entries_.splice(entries_.begin(), entries_, it);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
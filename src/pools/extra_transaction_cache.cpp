@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/extra_transaction_cache.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+#include <bitcoin/blockchain/pools/short_id_table.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// Slot states for a fill.
+static constexpr uint8_t slot_unfilled = 0;
+static constexpr uint8_t slot_filled = 1;
+static constexpr uint8_t slot_ambiguous = 2;
+
+extra_transaction_cache::extra_transaction_cache(size_t capacity)
+  : capacity_(capacity),
+    hits_(0),
+    misses_(0),
+    next_(0)
+{
+}
+
+size_t extra_transaction_cache::capacity() const
+{
+    return capacity_;
+}
+
+size_t extra_transaction_cache::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return ring_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t extra_transaction_cache::hits() const
+{
+    return hits_.load();
+}
+
+size_t extra_transaction_cache::misses() const
+{
+    return misses_.load();
+}
+
+void extra_transaction_cache::add(transaction_const_ptr tx)
+{
+    if (capacity_ == 0)
+        return;
+
+    // Short ids commit to the witness hash, except on BCH.
+#ifdef BITPRIM_CURRENCY_BCH
+    const auto id_hash = tx->hash();
+#else
+    const auto id_hash = tx->hash(true);
+#endif
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (ring_.size() < capacity_)
+    {
+        ring_.push_back(tx);
+        id_hashes_.push_back(id_hash);
+        return;
+    }
+
+    ring_[next_] = tx;
+    id_hashes_[next_] = id_hash;
+    next_ = (next_ + 1) % capacity_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void extra_transaction_cache::fill(
+    std::vector<chain::transaction>& txn_available, size_t& out_count,
+    uint64_t k0, uint64_t k1, const short_id_map& short_ids)
+{
+    // An ambiguous slot remains empty however many entries match it.
+    std::vector<uint8_t> states(txn_available.size(), slot_unfilled);
+    size_t filled = 0;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+
+    for (size_t entry = 0; entry < ring_.size(); ++entry)
+    {
+        const auto id = short_id_table::short_id(k0, k1, id_hashes_[entry]);
+        const auto it = short_ids.find(id);
+
+        if (it == short_ids.end())
+            continue;
+
+        auto& state = states[it->second];
+
+        if (state == slot_ambiguous)
+            continue;
+
+        auto& slot = txn_available[it->second];
+        const auto& tx = *ring_[entry];
+
+        if (!slot.is_valid())
+        {
+            slot = tx;
+            state = slot_filled;
+            ++filled;
+            ++out_count;
+        }
+        else if (slot.hash() != tx.hash())
+        {
+            if (state == slot_filled)
+                --filled;
+
+            slot = chain::transaction{};
+            state = slot_ambiguous;
+            --out_count;
+        }
+    }
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    size_t unfilled = 0;
+
+    for (const auto& id: short_ids)
+        if (!txn_available[id.second].is_valid())
+            ++unfilled;
+
+    hits_ += filled;
+    misses_ += unfilled;
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/header_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+header_index::header_index()
+{
+}
+
+size_t header_index::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return hashes_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_index::reserve(size_t size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    hashes_.reserve(size);
+    merkles_.reserve(size);
+    bits_.reserve(size);
+    timestamps_.reserve(size);
+    versions_.reserve(size);
+    nonces_.reserve(size);
+    works_.reserve(size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::push(const chain::header& header, size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    // Gaps are not indexed, readers fall back to the store above the index.
+    if (height != hashes_.size())
+        return false;
+
+    hashes_.push_back(header.hash());
+    merkles_.push_back(header.merkle());
+    bits_.push_back(header.bits());
+    timestamps_.push_back(header.timestamp());
+    versions_.push_back(header.version());
+    nonces_.push_back(header.nonce());
+
+    const auto proof = chain::header::proof(header.bits());
+    works_.push_back(works_.empty() ? proof : works_.back() + proof);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_index::pop_above(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto size = safe_add(height, size_t(1));
+
+    if (size >= hashes_.size())
+        return;
+
+    hashes_.resize(size);
+    merkles_.resize(size);
+    bits_.resize(size);
+    timestamps_.resize(size);
+    versions_.resize(size);
+    nonces_.resize(size);
+    works_.resize(size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void header_index::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    hashes_.clear();
+    merkles_.clear();
+    bits_.clear();
+    timestamps_.clear();
+    versions_.clear();
+    nonces_.clear();
+    works_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_block_hash(hash_digest& out_hash, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height >= hashes_.size())
+        return false;
+
+    out_hash = hashes_[height];
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_bits(uint32_t& out_bits, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height >= bits_.size())
+        return false;
+
+    out_bits = bits_[height];
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_timestamp(uint32_t& out_timestamp, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height >= timestamps_.size())
+        return false;
+
+    out_timestamp = timestamps_[height];
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_version(uint32_t& out_version, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height >= versions_.size())
+        return false;
+
+    out_version = versions_[height];
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_header(chain::header& out_header, size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (height >= hashes_.size())
+        return false;
+
+    // The previous block hash is the hash of the preceding height.
+    const auto& previous = height == 0 ? null_hash : hashes_[height - 1];
+
+    out_header = chain::header(versions_[height], previous, merkles_[height],
+        timestamps_[height], bits_[height], nonces_[height]);
+    out_header.validation.height = height;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_index::get_branch_work(uint256_t& out_work,
+    const uint256_t& maximum, size_t from_height, size_t to_height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    if (to_height >= works_.size())
+        return false;
+
+    out_work = 0;
+
+    if (from_height > to_height || maximum == 0)
+        return true;
+
+    const uint256_t base = from_height == 0 ? 0 : works_[from_height - 1];
+    const auto first = works_.begin() + from_height;
+    const auto last = works_.begin() + to_height + 1;
+
+    // Cumulative work is ascending, so find the first height at maximum.
+    const auto it = std::lower_bound(first, last, base + maximum);
+    out_work = (it == last ? works_[to_height] : *it) - base;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/in_flight_transactions.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+size_t in_flight_transactions::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool in_flight_transactions::reserve(transaction_const_ptr tx,
+    result_handler handler, code& out_ec)
+{
+    const auto& inputs = tx->inputs();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // A repeat of a transaction in flight does not conflict with it.
+    if (in_flight_.find(tx->hash()) != in_flight_.end())
+    {
+        out_ec = error::duplicate_transaction;
+        return false;
+    }
+
+    for (const auto& input: inputs)
+    {
+        const auto parent = in_flight_.find(input.previous_output().hash());
+
+        if (parent != in_flight_.end())
+        {
+            parent->second.emplace_back(tx, handler);
+            out_ec = error::success;
+            return false;
+        }
+    }
+
+    for (const auto& input: inputs)
+    {
+        if (spends_.find(input.previous_output()) != spends_.end())
+        {
+            out_ec = error::double_spend;
+            return false;
+        }
+    }
+
+    for (const auto& input: inputs)
+        spends_.insert(input.previous_output());
+
+    in_flight_.emplace(tx->hash(), deferred_list{});
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+in_flight_transactions::deferred_list in_flight_transactions::release(
+    transaction_const_ptr tx)
+{
+    deferred_list children;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& input: tx->inputs())
+        spends_.erase(input.previous_output());
+
+    const auto it = in_flight_.find(tx->hash());
+
+    if (it != in_flight_.end())
+    {
+        children = std::move(it->second);
+        in_flight_.erase(it);
+    }
+
+    return children;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/mempool_address_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+using namespace bc::wallet;
+
+mempool_address_index::mempool_address_index()
+{
+}
+
+size_t mempool_address_index::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return addresses_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Addresses are extracted outside of the critical section.
+void mempool_address_index::add(const chain::transaction& tx,
+    const chain::output::list& prevouts, uint32_t timestamp)
+{
+    const auto hash = tx.hash();
+    std::vector<std::pair<payment_address, row>> rows;
+
+    const auto& outputs = tx.outputs();
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto& output = outputs[index];
+        const auto extracted = payment_address::extract(output.script(),
+            payment_address::mainnet_p2kh, payment_address::mainnet_p2sh);
+
+        for (const auto& address: extracted)
+            if (address)
+                rows.push_back({ address, { hash, index, false,
+                    output.value(), {}, timestamp } });
+    }
+
+    // The address of a spend is that of the output it spends.
+    const auto& inputs = tx.inputs();
+    const auto count = std::min(inputs.size(), prevouts.size());
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        const auto& prevout = prevouts[index];
+
+        // The address and value of an unresolved prevout are unknown.
+        if (!prevout.is_valid())
+            continue;
+
+        const auto extracted = payment_address::extract(prevout.script(),
+            payment_address::mainnet_p2kh, payment_address::mainnet_p2sh);
+
+        for (const auto& address: extracted)
+            if (address)
+                rows.push_back({ address, { hash, index, true,
+                    prevout.value(), inputs[index].previous_output(),
+                    timestamp } });
+    }
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    auto& keys = addresses_[hash];
+
+    // A transaction is indexed once.
+    if (!keys.empty())
+        return;
+
+    for (const auto& item: rows)
+    {
+        rows_[item.first][hash].push_back(item.second);
+
+        if (std::find(keys.begin(), keys.end(), item.first) == keys.end())
+            keys.push_back(item.first);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void mempool_address_index::remove(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = addresses_.find(hash);
+
+    if (it == addresses_.end())
+        return;
+
+    for (const auto& address: it->second)
+    {
+        const auto found = rows_.find(address);
+
+        if (found == rows_.end())
+            continue;
+
+        auto& transactions = found->second;
+        transactions.erase(hash);
+
+        if (transactions.empty())
+            rows_.erase(found);
+    }
+
+    addresses_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void mempool_address_index::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    rows_.clear();
+    addresses_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+mempool_address_index::list mempool_address_index::get(
+    const payment_address& address) const
+{
+    const auto key = normalize(address);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = rows_.find(key);
+
+    if (it == rows_.end())
+        return list{};
+
+    list rows;
+
+    for (const auto& transaction: it->second)
+        rows.insert(rows.end(), transaction.second.begin(),
+            transaction.second.end());
+
+    return rows;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Testnet addresses are mapped to the mainnet form of the same hash.
+payment_address mempool_address_index::normalize(
+    const payment_address& address)
+{
+    const auto version = address.version();
+    const auto p2sh = version == payment_address::mainnet_p2sh ||
+        version == payment_address::testnet_p2sh;
+
+    return payment_address(address.hash(), p2sh ?
+        payment_address::mainnet_p2sh : payment_address::mainnet_p2kh);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/merkle_tree.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+static hash_digest hash_pair(const hash_digest& left, const hash_digest& right)
+{
+    return bitcoin_hash(build_chunk({ left, right }));
+}
+
+merkle_tree::merkle_tree()
+  : levels_(1)
+{
+}
+
+size_t merkle_tree::size() const
+{
+    return levels_.front().size();
+}
+
+void merkle_tree::update(const hash_list& leaves)
+{
+    const auto& current = levels_.front();
+    const auto common = std::min(current.size(), leaves.size());
+    const auto mismatch = std::mismatch(current.begin(),
+        current.begin() + common, leaves.begin());
+
+    // The number of leading nodes of a level that are unchanged.
+    size_t valid = std::distance(current.begin(), mismatch.first);
+
+    if (valid == current.size() && valid == leaves.size())
+        return;
+
+    levels_.front() = leaves;
+    size_t level = 0;
+
+    while (levels_[level].size() > 1)
+    {
+        if (levels_.size() == level + 1)
+            levels_.emplace_back();
+
+        const auto& below = levels_[level];
+        auto& above = levels_[level + 1];
+        const auto count = (below.size() + 1) / 2;
+
+        // A node is unchanged if both of its children are unchanged.
+        valid /= 2;
+        above.resize(count);
+
+        for (auto node = valid; node < count; ++node)
+        {
+            const auto left = 2 * node;
+            const auto right = left + 1;
+            above[node] = hash_pair(below[left],
+                right < below.size() ? below[right] : below[left]);
+        }
+
+        ++level;
+    }
+
+    levels_.resize(level + 1);
+}
+
+hash_list merkle_tree::branch() const
+{
+    hash_list out;
+
+    // The top level is the root (or the only leaf), which has no sibling.
+    for (size_t level = 0; level + 1 < levels_.size(); ++level)
+        out.push_back(levels_[level][1]);
+
+    return out;
+}
+
+hash_digest merkle_tree::root(const hash_digest& first) const
+{
+    auto out = first;
+
+    for (const auto& sibling: branch())
+        out = hash_pair(out, sibling);
+
+    return out;
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/short_id_table.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/bitcoin/math/sip_hash.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+// Short ids are computed in batches of this many entries, each batch hashed
+// before it is probed, so that the independent hashes are pipelined.
+static constexpr size_t batch_size = 64;
+
+// Slot states for resolution.
+static constexpr uint8_t slot_empty = 0;
+static constexpr uint8_t slot_resolved = 1;
+static constexpr uint8_t slot_ambiguous = 2;
+
+uint64_t short_id_table::short_id(uint64_t k0, uint64_t k1,
+    const hash_digest& hash)
+{
+    return sip_hash_uint256(k0, k1, hash) & uint64_t(0xffffffffffff);
+}
+
+short_id_table::short_id_table()
+{
+}
+
+size_t short_id_table::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return txids_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void short_id_table::add(const hash_digest& txid, const hash_digest& id_hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (!positions_.emplace(txid, txids_.size()).second)
+        return;
+
+    id_hashes_.push_back(id_hash);
+    txids_.push_back(txid);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The last entry is moved into the vacated position, keeping the arrays dense.
+void short_id_table::remove(const hash_digest& txid)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = positions_.find(txid);
+
+    if (it == positions_.end())
+        return;
+
+    const auto position = it->second;
+    const auto last = txids_.size() - 1;
+    positions_.erase(it);
+
+    if (position != last)
+    {
+        id_hashes_[position] = id_hashes_[last];
+        txids_[position] = txids_[last];
+        positions_[txids_[position]] = position;
+    }
+
+    id_hashes_.pop_back();
+    txids_.pop_back();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void short_id_table::clear()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    id_hashes_.clear();
+    txids_.clear();
+    positions_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t short_id_table::resolve(hash_list& out_txids, uint64_t k0,
+    uint64_t k1, const short_id_map& short_ids) const
+{
+    std::vector<uint8_t> states(out_txids.size(), slot_empty);
+    std::array<uint64_t, batch_size> batch;
+    size_t resolved = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto count = id_hashes_.size();
+
+    for (size_t start = 0; start < count; start += batch_size)
+    {
+        const auto end = std::min(start + batch_size, count);
+
+        for (auto entry = start; entry < end; ++entry)
+            batch[entry - start] = short_id(k0, k1, id_hashes_[entry]);
+
+        for (auto entry = start; entry < end; ++entry)
+        {
+            const auto it = short_ids.find(batch[entry - start]);
+
+            if (it == short_ids.end())
+                continue;
+
+            const auto slot = it->second;
+
+            // Two entries matching a short id are ambiguous, so the slot is
+            // left to be requested rather than risking a failed block fill.
+            if (states[slot] == slot_empty)
+            {
+                states[slot] = slot_resolved;
+                out_txids[slot] = txids_[entry];
+                ++resolved;
+            }
+            else if (states[slot] == slot_resolved)
+            {
+                states[slot] = slot_ambiguous;
+                out_txids[slot] = null_hash;
+                --resolved;
+            }
+        }
+
+        // Ambiguity is not detected past this point, but the early exit is
+        // worth the small risk (as in the reference implementation).
+        if (resolved == short_ids.size())
+            break;
+    }
+
+    return resolved;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+short_id_table::short_id_list short_id_table::short_ids(uint64_t k0,
+    uint64_t k1) const
+{
+    short_id_list out;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    out.reserve(txids_.size());
+
+    for (size_t entry = 0; entry < txids_.size(); ++entry)
+        out.emplace_back(short_id(k0, k1, id_hashes_[entry]), txids_[entry]);
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
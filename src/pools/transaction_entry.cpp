@@ -20,7 +20,6 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <algorithm>
 #include <iostream>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
@@ -28,6 +27,8 @@
 namespace libbitcoin {
 namespace blockchain {
 
+const transaction_entry::handle transaction_entry::null_handle = max_uint32;
+
 // Space optimization since valid sigops and size are never close to 32 bits.
 inline uint32_t cap(size_t value)
 {
@@ -42,7 +43,17 @@ transaction_entry::transaction_entry(transaction_const_ptr tx)
    fees_(tx->fees()),
    forks_(tx->validation.state->enabled_forks()),
    hash_(tx->hash()),
-   marked_(false)
+   transaction_(tx),
+   ancestor_count_(1),
+   ancestor_size_(size_),
+   ancestor_fees_(fees_),
+   ancestor_sigops_(sigops_),
+   descendant_count_(1),
+   descendant_size_(size_),
+   descendant_fees_(fees_),
+   marked_(false),
+   parents_(null_handle),
+   children_(null_handle)
 {
 }
 
@@ -53,13 +64,22 @@ transaction_entry::transaction_entry(const hash_digest& hash)
    fees_(0),
    forks_(0),
    hash_(hash),
-   marked_(false)
+   ancestor_count_(0),
+   ancestor_size_(0),
+   ancestor_fees_(0),
+   ancestor_sigops_(0),
+   descendant_count_(0),
+   descendant_size_(0),
+   descendant_fees_(0),
+   marked_(false),
+   parents_(null_handle),
+   children_(null_handle)
 {
 }
 
 bool transaction_entry::is_anchor() const
 {
-    return parents_.empty();
+    return parents_ == null_handle;
 }
 
 // Not valid if the entry is a search key.
@@ -92,56 +112,93 @@ const hash_digest& transaction_entry::hash() const
     return hash_;
 }
 
-void transaction_entry::mark(bool value)
+// Not valid if the entry is a search key.
+transaction_const_ptr transaction_entry::transaction() const
 {
-    marked_ = value;
+    return transaction_;
 }
 
-bool transaction_entry::is_marked() const
+size_t transaction_entry::ancestor_count() const
 {
-    return marked_;
+    return ancestor_count_;
 }
 
-// Not valid if the entry is a search key.
-const transaction_entry::list& transaction_entry::parents() const
+size_t transaction_entry::ancestor_size() const
 {
-    return parents_;
+    return ancestor_size_;
 }
 
-// Not valid if the entry is a search key.
-const transaction_entry::list& transaction_entry::children() const
+uint64_t transaction_entry::ancestor_fees() const
+{
+    return ancestor_fees_;
+}
+
+size_t transaction_entry::ancestor_sigops() const
+{
+    return ancestor_sigops_;
+}
+
+// The package feerate by which templates are optimized.
+double transaction_entry::ancestor_score() const
+{
+    return ancestor_size_ == 0 ? 0.0 :
+        static_cast<double>(ancestor_fees_) / ancestor_size_;
+}
+
+void transaction_entry::set_ancestors(size_t count, size_t size,
+    uint64_t fees, size_t sigops)
+{
+    ancestor_count_ = cap(count);
+    ancestor_size_ = cap(size);
+    ancestor_fees_ = fees;
+    ancestor_sigops_ = cap(sigops);
+}
+
+size_t transaction_entry::descendant_count() const
+{
+    return descendant_count_;
+}
+
+size_t transaction_entry::descendant_size() const
+{
+    return descendant_size_;
+}
+
+uint64_t transaction_entry::descendant_fees() const
 {
-    return children_;
+    return descendant_fees_;
 }
 
-// This is not guarded against redundant entries.
-void transaction_entry::add_parent(ptr parent)
+// The package feerate by which the pool is evicted.
+double transaction_entry::descendant_score() const
 {
-    parents_.push_back(parent);
+    return descendant_size_ == 0 ? 0.0 :
+        static_cast<double>(descendant_fees_) / descendant_size_;
 }
 
-// This is not guarded against redundant entries.
-void transaction_entry::add_child(ptr child)
+void transaction_entry::set_descendants(size_t count, size_t size,
+    uint64_t fees)
 {
-    children_.push_back(child);
+    descendant_count_ = cap(count);
+    descendant_size_ = cap(size);
+    descendant_fees_ = fees;
 }
 
-// This is guarded against missing entries.
-void transaction_entry::remove_child(ptr child)
+void transaction_entry::mark(bool value)
 {
-    const auto it = find(children_.begin(), children_.end(), child);
+    marked_ = value;
+}
 
-    // TODO: this is a placeholder for subtree purge.
-    // TODO: manage removal of bidirectional link add/remove.
-    if (it != children_.end())
-        children_.erase(it);
+bool transaction_entry::is_marked() const
+{
+    return marked_;
 }
 
 std::ostream& operator<<(std::ostream& out, const transaction_entry& of)
 {
     out << encode_hash(of.hash_)
-        << " " << of.parents_.size()
-        << " " << of.children_.size();
+        << " " << of.ancestor_count_
+        << " " << of.ancestor_size_;
     return out;
 }
 
@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/blockchain/pools/transaction_entry_store.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/blockchain/define.hpp>
+
+namespace libbitcoin {
+namespace blockchain {
+
+static const auto null_handle = transaction_entry::null_handle;
+
+transaction_entry_store::transaction_entry_store()
+{
+}
+
+size_t transaction_entry_store::size() const
+{
+    return entries_.size() - free_entries_.size();
+}
+
+size_t transaction_entry_store::capacity() const
+{
+    return entries_.size();
+}
+
+transaction_entry_store::handle transaction_entry_store::insert(
+    transaction_entry&& entry)
+{
+    entry.parents_ = null_handle;
+    entry.children_ = null_handle;
+
+    if (!free_entries_.empty())
+    {
+        const auto slot = free_entries_.back();
+        free_entries_.pop_back();
+        entries_[slot] = std::move(entry);
+        return slot;
+    }
+
+    BITCOIN_ASSERT(entries_.size() < null_handle);
+    entries_.push_back(std::move(entry));
+    return static_cast<handle>(entries_.size() - 1);
+}
+
+// Links are bidirectional, so the entry is also unlinked from each parent's
+// child list and from each child's parent list.
+void transaction_entry_store::erase(handle entry)
+{
+    auto& value = entries_[entry];
+
+    for (auto it = value.parents_; it != null_handle; it = edges_[it].next)
+        unlink(entries_[edges_[it].entry].children_, entry);
+
+    for (auto it = value.children_; it != null_handle; it = edges_[it].next)
+        unlink(entries_[edges_[it].entry].parents_, entry);
+
+    release(value.parents_);
+    release(value.children_);
+
+    // This releases the transaction, the slot is retained for reuse.
+    value = transaction_entry{ null_hash };
+    free_entries_.push_back(entry);
+}
+
+transaction_entry& transaction_entry_store::get(handle entry)
+{
+    return entries_[entry];
+}
+
+const transaction_entry& transaction_entry_store::get(handle entry) const
+{
+    return entries_[entry];
+}
+
+bool transaction_entry_store::link(handle parent, handle child)
+{
+    // A transaction may spend more than one output of the same parent.
+    for (auto it = entries_[parent].children_; it != null_handle;
+        it = edges_[it].next)
+        if (edges_[it].entry == child)
+            return false;
+
+    // Allocation may move edges but not entries.
+    const auto child_edge = allocate_edge(child, entries_[parent].children_);
+    entries_[parent].children_ = child_edge;
+
+    const auto parent_edge = allocate_edge(parent, entries_[child].parents_);
+    entries_[child].parents_ = parent_edge;
+    return true;
+}
+
+void transaction_entry_store::parents(handle entry, handles& out) const
+{
+    for (auto it = entries_[entry].parents_; it != null_handle;
+        it = edges_[it].next)
+        out.push_back(edges_[it].entry);
+}
+
+void transaction_entry_store::children(handle entry, handles& out) const
+{
+    for (auto it = entries_[entry].children_; it != null_handle;
+        it = edges_[it].next)
+        out.push_back(edges_[it].entry);
+}
+
+// Utilities.
+//-----------------------------------------------------------------------------
+
+transaction_entry_store::handle transaction_entry_store::allocate_edge(
+    handle entry, handle next)
+{
+    if (!free_edges_.empty())
+    {
+        const auto slot = free_edges_.back();
+        free_edges_.pop_back();
+        edges_[slot] = { entry, next };
+        return slot;
+    }
+
+    BITCOIN_ASSERT(edges_.size() < null_handle);
+    edges_.push_back({ entry, next });
+    return static_cast<handle>(edges_.size() - 1);
+}
+
+// Remove the first edge to the entry from the list at head.
+void transaction_entry_store::unlink(handle& head, handle entry)
+{
+    for (auto link = &head; *link != null_handle; link = &edges_[*link].next)
+    {
+        if (edges_[*link].entry == entry)
+        {
+            const auto edge = *link;
+            *link = edges_[edge].next;
+            free_edges_.push_back(edge);
+            return;
+        }
+    }
+}
+
+void transaction_entry_store::release(handle head)
+{
+    for (auto it = head; it != null_handle; it = edges_[it].next)
+        free_edges_.push_back(it);
+}
+
+} // namespace blockchain
+} // namespace libbitcoin
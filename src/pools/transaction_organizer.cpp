@@ -47,6 +47,7 @@ transaction_organizer::transaction_organizer(prioritized_mutex& mutex,
     stopped_(true),
     settings_(settings),
     dispatch_(dispatch),
+    push_dispatch_(push_pool_, NAME "_push"),
     transaction_pool_(settings),
     validator_(dispatch, fast_chain_, settings),
     subscriber_(std::make_shared<transaction_subscriber>(thread_pool, NAME))
@@ -69,15 +70,23 @@ bool transaction_organizer::start()
     stopped_ = false;
     subscriber_->start();
     validator_.start();
+
+    // The push thread is released by stop, so the pool is restartable.
+    push_pool_.spawn(1);
     return true;
 }
 
+// A push waits on the low priority lock, so this must not be called while
+// the high priority lock is held (the pushes are drained here).
 bool transaction_organizer::stop()
 {
+    stopped_ = true;
+    push_pool_.shutdown();
+    push_pool_.join();
+
     validator_.stop();
     subscriber_->stop();
     subscriber_->invoke(error::service_stopped, {});
-    stopped_ = true;
     return true;
 }
 
@@ -158,26 +167,30 @@ void transaction_organizer::validate_handle_connect(code const& ec, transaction_
 //-----------------------------------------------------------------------------
 
 // This is called from block_chain::organize.
+// The caller is not held for validation, the handler is invoked on completion.
 void transaction_organizer::organize(transaction_const_ptr tx,
     result_handler handler)
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    mutex_.lock_low_priority();
-
     if (stopped())
     {
-        mutex_.unlock_low_priority();
         handler(error::service_stopped);
         return;
     }
 
-    // Reset the reusable promise.
-    resume_ = std::promise<code>();
+    code ec;
+
+    // Deferred transactions are organized when their parent completes.
+    if (!in_flight_.reserve(tx, handler, ec))
+    {
+        if (ec)
+            handler(ec);
+
+        return;
+    }
 
     const result_handler complete =
-        std::bind(&transaction_organizer::signal_completion,
-            this, _1);
+        std::bind(&transaction_organizer::handle_complete,
+            this, _1, tx, handler);
 
     const auto check_handler =
         std::bind(&transaction_organizer::handle_check,
@@ -185,25 +198,18 @@ void transaction_organizer::organize(transaction_const_ptr tx,
 
     // Checks that are independent of chain state.
     validator_.check(tx, check_handler);
-
-    // Wait on completion signal.
-    // This is necessary in order to continue on a non-priority thread.
-    // If we do not wait on the original thread there may be none left.
-    auto ec = resume_.get_future().get();
-
-    mutex_.unlock_low_priority();
-    ///////////////////////////////////////////////////////////////////////////
-
-    // Invoke caller handler outside of critical section.
-    handler(ec);
 }
 
 // private
-void transaction_organizer::signal_completion(const code& ec)
+void transaction_organizer::handle_complete(const code& ec,
+    transaction_const_ptr tx, result_handler handler)
 {
-    // This must be protected so that it is properly cleared.
-    // Signal completion, which results in original handler invoke with code.
-    resume_.set_value(ec);
+    const auto children = in_flight_.release(tx);
+    handler(ec);
+
+    // Children of a rejected parent are organized so as to be reported.
+    for (const auto& child: children)
+        organize(child.first, child.second);
 }
 
 // Verify sub-sequence.
@@ -292,6 +298,35 @@ void transaction_organizer::handle_connect(const code& ec,
         return;
     }
 
+    // The push waits on the low priority lock, so it is run on its own
+    // thread, not on the network threads or the priority threads.
+    push_dispatch_.concurrent(&transaction_organizer::push,
+        this, tx, handler);
+}
+
+// private
+void transaction_organizer::push(transaction_const_ptr tx,
+    result_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::service_stopped);
+        return;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_low_priority();
+
+    // A block organized since acceptance invalidates the population of the
+    // previous outputs, so the transaction is accepted again.
+    if (tx->validation.state != fast_chain_.chain_state())
+    {
+        mutex_.unlock_low_priority();
+        reaccept(tx, handler);
+        return;
+    }
+
     const auto pushed_handler =
         std::bind(&transaction_organizer::handle_pushed,
             this, _1, tx, handler);
@@ -305,6 +340,9 @@ void transaction_organizer::handle_connect(const code& ec,
 void transaction_organizer::handle_pushed(const code& ec,
     transaction_const_ptr tx, result_handler handler)
 {
+    mutex_.unlock_low_priority();
+    ///////////////////////////////////////////////////////////////////////////
+
     if (ec)
     {
         LOG_FATAL(LOG_BLOCKCHAIN)
@@ -320,13 +358,81 @@ void transaction_organizer::handle_pushed(const code& ec,
     handler(error::success);
 }
 
+// Reaccept sub-sequence.
+//-----------------------------------------------------------------------------
+
+// private
+// The scripts are connected against the previous outputs and forks of the
+// prior acceptance, which are retained to avoid connecting them again.
+void transaction_organizer::reaccept(transaction_const_ptr tx,
+    result_handler handler)
+{
+    const auto forks = tx->validation.state->enabled_forks();
+    chain::output::list prevouts;
+    prevouts.reserve(tx->inputs().size());
+
+    for (const auto& input: tx->inputs())
+        prevouts.push_back(input.previous_output().validation.cache);
+
+    const auto reaccept_handler =
+        std::bind(&transaction_organizer::handle_reaccept,
+            this, _1, tx, forks, std::move(prevouts), handler);
+
+    validator_.accept(tx, reaccept_handler);
+}
+
+// private
+void transaction_organizer::handle_reaccept(const code& ec,
+    transaction_const_ptr tx, uint32_t forks,
+    const chain::output::list& prevouts, result_handler handler)
+{
+    if (stopped())
+    {
+        handler(error::service_stopped);
+        return;
+    }
+
+    if (ec)
+    {
+        handler(ec);
+        return;
+    }
+
+    // The pool minimum fee may have been raised since acceptance.
+    if (tx->fees() < price(tx))
+    {
+        handler(error::insufficient_fee);
+        return;
+    }
+
+    auto changed = tx->validation.state->enabled_forks() != forks;
+    const auto& inputs = tx->inputs();
+
+    for (size_t index = 0; !changed && index < inputs.size(); ++index)
+        changed = inputs[index].previous_output().validation.cache !=
+            prevouts[index];
+
+    if (changed)
+    {
+        const auto connect_handler =
+            std::bind(&transaction_organizer::handle_connect,
+                this, _1, tx, handler);
+
+        validator_.connect(tx, connect_handler);
+        return;
+    }
+
+    push_dispatch_.concurrent(&transaction_organizer::push,
+        this, tx, handler);
+}
+
 // Subscription.
 //-----------------------------------------------------------------------------
 
 // private
 void transaction_organizer::notify(transaction_const_ptr tx)
 {
-    // This invokes handlers within the criticial section (deadlock risk).
+    // This invokes handlers on the push thread, outside of the lock.
     subscriber_->invoke(error::success, tx);
 }
 
@@ -346,13 +452,31 @@ void transaction_organizer::unsubscribe()
 void transaction_organizer::fetch_template(
     merkle_block_fetch_handler handler) const
 {
-    transaction_pool_.fetch_template(handler);
+    size_t top;
+
+    if (!fast_chain_.get_last_height(top))
+    {
+        handler(error::not_found, nullptr, 0);
+        return;
+    }
+
+    transaction_pool_.fetch_template(top + 1, handler);
 }
 
 void transaction_organizer::fetch_mempool(size_t maximum,
-    inventory_fetch_handler handler) const
+    uint64_t minimum_fee, inventory_fetch_handler handler) const
+{
+    transaction_pool_.fetch_mempool(maximum, minimum_fee, handler);
+}
+
+transaction_pool& transaction_organizer::pool()
+{
+    return transaction_pool_;
+}
+
+const transaction_pool& transaction_organizer::pool() const
 {
-    transaction_pool_.fetch_mempool(maximum, handler);
+    return transaction_pool_;
 }
 
 // Utility.
@@ -363,17 +487,23 @@ uint64_t transaction_organizer::price(transaction_const_ptr tx) const
     const auto byte_fee = settings_.byte_fee_satoshis;
     const auto sigop_fee = settings_.sigop_fee_satoshis;
 
+    // The pool minimum (satoshis per kilobyte) is raised as the pool evicts.
+    const auto minimum_fee = transaction_pool_.minimum_fee();
+
     // Guard against summing signed values by testing independently.
-    if (byte_fee == 0.0f && sigop_fee == 0.0f)
+    if (byte_fee == 0.0f && sigop_fee == 0.0f && minimum_fee == 0)
         return 0;
 
     // TODO: this is a second pass on size and sigops, implement cache.
     // This at least prevents uncached calls when zero fee is configured.
-    auto byte = byte_fee > 0 ? byte_fee * tx->serialized_size(true) : 0;
+    const auto size = tx->serialized_size(true);
+    auto byte = byte_fee > 0 ? byte_fee * size : 0;
     auto sigop = sigop_fee > 0 ? sigop_fee * tx->signature_operations() : 0;
+    const auto pool_fee = minimum_fee * size / 1000;
 
     // Require at least one satoshi per tx if there are any fees configured.
-    return std::max(uint64_t(1), static_cast<uint64_t>(byte + sigop));
+    return std::max({ uint64_t(1), static_cast<uint64_t>(byte + sigop),
+        pool_fee });
 }
 
 } // namespace blockchain
@@ -18,8 +18,15 @@
  */
 #include <bitcoin/blockchain/pools/transaction_pool.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <ctime>
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/settings.hpp>
 
@@ -32,26 +39,671 @@ namespace blockchain {
 // exmaple implementation simply tests all txs in a new block against
 // transactions in previous blocks.
 
+// Selection stops after this many consecutive packages fail to fit...
+static constexpr size_t maximum_failures = 1000;
+
+// ...once the template is within this many bytes of its limit.
+static constexpr size_t minimum_remaining = 4000;
+
+// The minimum feerate is raised this far above an evicted package, and is
+// dropped once it decays below half of it (satoshis per kilobyte).
+static constexpr uint64_t incremental_fee = 1000;
+
+// The minimum feerate halves over this period (faster when mostly empty).
+static constexpr double minimum_fee_halflife = 12 * 60 * 60;
+
+static double score(size_t size, uint64_t fees)
+{
+    return size == 0 ? 0.0 : static_cast<double>(fees) / size;
+}
+
 transaction_pool::transaction_pool(const settings& settings)
-  ////: reject_conflicts_(settings.reject_conflicts),
-  ////  minimum_fee_(settings.minimum_fee_satoshis)
+  : transaction_pool(settings,
+        get_max_block_size() - coinbase_reserved_size)
 {
 }
 
-// TODO: implement block template discovery.
-void transaction_pool::fetch_template(merkle_block_fetch_handler handler) const
+transaction_pool::transaction_pool(const settings& settings,
+    size_t max_template_size)
+  : max_template_size_(max_template_size),
+    capacity_(settings.transaction_pool_capacity),
+    index_(score_compare{ &store_ }),
+    eviction_(eviction_compare{ &store_ }),
+    bytes_(0),
+    minimum_fee_(0),
+    minimum_fee_time_(0),
+    version_(0),
+    selection_version_(0)
+  ////reject_conflicts_(settings.reject_conflicts),
+  ////minimum_fee_(settings.minimum_fee_satoshis)
 {
-    const size_t height = max_size_t;
-    const auto block = std::make_shared<message::merkle_block>();
+}
+
+// The header is not populated, the pool does not assemble blocks.
+void transaction_pool::fetch_template(size_t height,
+    merkle_block_fetch_handler handler) const
+{
+    const auto entries = selection();
+    hash_list hashes;
+    hashes.reserve(entries.size());
+
+    for (const auto& entry: entries)
+        hashes.push_back(entry.hash());
+
+    const auto block = std::make_shared<message::merkle_block>(
+        chain::header{}, hashes.size(), hashes, data_chunk{});
     handler(error::success, block, height);
 }
 
-// TODO: implement mempool message payload discovery.
-void transaction_pool::fetch_mempool(size_t maximum,
+// Buckets are visited from the highest feerate down to the minimum, so the
+// reply is built without visiting entries below the fee filter.
+void transaction_pool::fetch_mempool(size_t maximum, uint64_t minimum_fee,
     inventory_fetch_handler handler) const
 {
-    const auto empty = std::make_shared<message::inventory>();
-    handler(error::success, empty);
+    static const auto id = message::inventory::type_id::transaction;
+    const auto out = std::make_shared<message::inventory>();
+    handles found;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+
+    const feerate_index::const_reverse_iterator end(
+        buckets_.lower_bound(minimum_fee));
+
+    for (auto bucket = buckets_.rbegin();
+        bucket != end && found.size() < maximum; ++bucket)
+    {
+        for (const auto entry: bucket->second)
+        {
+            if (found.size() == maximum)
+                break;
+
+            found.push_back(entry);
+        }
+    }
+
+    // Sort by depth while the ancestor counts are stable.
+    std::stable_sort(found.begin(), found.end(),
+        [this](handle left, handle right)
+        {
+            return store_.get(left).ancestor_count() <
+                store_.get(right).ancestor_count();
+        });
+
+    out->inventories().reserve(found.size());
+
+    for (const auto entry: found)
+        out->inventories().emplace_back(id, store_.get(entry).hash());
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    handler(error::success, out);
+}
+
+// Properties.
+//-----------------------------------------------------------------------------
+
+size_t transaction_pool::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool transaction_pool::exists(const hash_digest& hash) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return entries_.find(hash) != entries_.end();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t transaction_pool::bytes() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return bytes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t transaction_pool::minimum_fee() const
+{
+    const auto now = std::time(nullptr);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+    return decayed_minimum_fee(now);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Add/remove.
+//-----------------------------------------------------------------------------
+
+code transaction_pool::add(transaction_const_ptr tx)
+{
+    hash_list evicted;
+    return add(tx, evicted);
+}
+
+code transaction_pool::add(transaction_const_ptr tx, hash_list& out_evicted)
+{
+    transaction_entry value(tx);
+    const auto hash = value.hash();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (entries_.find(hash) != entries_.end())
+        return error::unspent_duplicate;
+
+    for (const auto& input: tx->inputs())
+        if (spenders_.find(input.previous_output()) != spenders_.end())
+            return error::double_spend;
+
+    const auto entry = store_.insert(std::move(value));
+
+    for (const auto& input: tx->inputs())
+    {
+        const auto& prevout = input.previous_output();
+        spenders_.emplace(prevout, entry);
+
+        const auto it = entries_.find(prevout.hash());
+
+        if (it != entries_.end())
+            store_.link(it->second, entry);
+    }
+
+    // A new entry has no pooled children, so no other package changes.
+    add_ancestors(entry);
+    entries_.emplace(hash, entry);
+    index_.insert(entry);
+    eviction_.insert(entry);
+    buckets_[feerate(store_.get(entry))].insert(entry);
+    bytes_ += store_.get(entry).size();
+    ++version_;
+
+    evict(out_evicted);
+    return entries_.find(hash) == entries_.end() ?
+        error::insufficient_fee : error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Block order is not topological under canonical (txid) ordering, so the
+// pooled confirmations are removed parents first, by ascending ancestor count.
+void transaction_pool::remove(block_const_ptr block)
+{
+    handles confirmed;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    ++version_;
+
+    for (const auto& tx: block->transactions())
+    {
+        const auto it = entries_.find(tx.hash());
+
+        if (it != entries_.end())
+            confirmed.push_back(it->second);
+    }
+
+    std::sort(confirmed.begin(), confirmed.end(),
+        [this](handle left, handle right)
+        {
+            return store_.get(left).ancestor_count() <
+                store_.get(right).ancestor_count();
+        });
+
+    for (const auto entry: confirmed)
+        remove_confirmed(entry);
+
+    // A confirmed spend invalidates the pooled spender and descendants.
+    for (const auto& tx: block->transactions())
+    {
+        for (const auto& input: tx.inputs())
+        {
+            const auto spender = spenders_.find(input.previous_output());
+
+            if (spender == spenders_.end())
+                continue;
+
+            const auto conflict = spender->second;
+            remove_conflict(conflict);
+        }
+    }
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Selection.
+//-----------------------------------------------------------------------------
+
+// Greedy selection by package feerate. Once an entry is selected the packages
+// of its unselected descendants shrink, so these are tracked as modified
+// packages and compete with the (unmodified) score index for the next pick.
+transaction_entry::list transaction_pool::select() const
+{
+    typedef std::pair<double, handle> modified_key;
+    typedef std::set<modified_key, std::greater<modified_key>> modified_index;
+
+    transaction_entry::list selected;
+    std::unordered_set<handle> included;
+    std::unordered_set<handle> failed;
+    std::unordered_map<handle, package> modified;
+    modified_index modified_scores;
+    size_t template_size = 0;
+    size_t template_sigops = 0;
+    size_t failures = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    auto it = index_.begin();
+
+    while (it != index_.end() || !modified_scores.empty())
+    {
+        const auto has_next = it != index_.end();
+
+        if (has_next && (included.count(*it) != 0 ||
+            failed.count(*it) != 0 || modified.count(*it) != 0))
+        {
+            ++it;
+            continue;
+        }
+
+        handle candidate;
+        package candidate_package;
+
+        if (!modified_scores.empty() && (!has_next ||
+            modified_scores.begin()->first > store_.get(*it).ancestor_score()))
+        {
+            candidate = modified_scores.begin()->second;
+            candidate_package = modified[candidate];
+            modified_scores.erase(modified_scores.begin());
+            modified.erase(candidate);
+        }
+        else
+        {
+            candidate = *it++;
+            const auto& entry = store_.get(candidate);
+            candidate_package = { entry.ancestor_size(),
+                entry.ancestor_fees(), entry.ancestor_sigops() };
+        }
+
+        if (!fits(template_size + candidate_package.size,
+            template_sigops + candidate_package.sigops))
+        {
+            // A descendant's package includes the rejected package, so it is
+            // rejected with it (and any reduced package of it is dropped).
+            failed.insert(candidate);
+
+            for (const auto descendant: descendants(candidate))
+            {
+                failed.insert(descendant);
+                const auto found = modified.find(descendant);
+
+                if (found != modified.end())
+                {
+                    modified_scores.erase({ score(found->second.size,
+                        found->second.fees), descendant });
+                    modified.erase(found);
+                }
+            }
+
+            if (template_size + minimum_remaining > max_template_size_ &&
+                ++failures > maximum_failures)
+                break;
+
+            continue;
+        }
+
+        failures = 0;
+        auto package_entries = ancestors(candidate);
+        package_entries.erase(std::remove_if(package_entries.begin(),
+            package_entries.end(), [&](handle entry)
+            {
+                return included.count(entry) != 0;
+            }), package_entries.end());
+
+        // An ancestor always has fewer ancestors than its descendants.
+        package_entries.push_back(candidate);
+        std::sort(package_entries.begin(), package_entries.end(),
+            [this](handle left, handle right)
+            {
+                return store_.get(left).ancestor_count() <
+                    store_.get(right).ancestor_count();
+            });
+
+        for (const auto entry: package_entries)
+        {
+            const auto& value = store_.get(entry);
+            selected.push_back(value);
+            included.insert(entry);
+            template_size += value.size();
+            template_sigops += value.sigops();
+
+            const auto found = modified.find(entry);
+
+            if (found != modified.end())
+            {
+                modified_scores.erase({ score(found->second.size,
+                    found->second.fees), entry });
+                modified.erase(found);
+            }
+        }
+
+        for (const auto entry: package_entries)
+        {
+            const auto& value = store_.get(entry);
+
+            for (const auto descendant: descendants(entry))
+            {
+                if (included.count(descendant) != 0)
+                    continue;
+
+                auto found = modified.find(descendant);
+
+                if (found == modified.end())
+                {
+                    const auto& next = store_.get(descendant);
+                    const package reduced{ next.ancestor_size(),
+                        next.ancestor_fees(), next.ancestor_sigops() };
+                    found = modified.emplace(descendant, reduced).first;
+                }
+                else
+                {
+                    modified_scores.erase({ score(found->second.size,
+                        found->second.fees), descendant });
+                }
+
+                auto& reduced = found->second;
+                reduced.size -= value.size();
+                reduced.fees -= value.fees();
+                reduced.sigops -= value.sigops();
+                modified_scores.insert({ score(reduced.size, reduced.fees),
+                    descendant });
+            }
+        }
+    }
+
+    return selected;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The pool version is read before selecting, so a concurrent change leaves
+// the retained selection stale rather than lost.
+transaction_entry::list transaction_pool::selection() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    std::lock_guard<std::mutex> lock(selection_mutex_);
+
+    mutex_.lock_shared();
+    const auto version = version_;
+    mutex_.unlock_shared();
+
+    if (version != selection_version_)
+    {
+        selection_ = select();
+        selection_version_ = version;
+    }
+
+    return selection_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Utilities.
+//-----------------------------------------------------------------------------
+
+// The sigop limit grows with the template size, as in block validation.
+bool transaction_pool::fits(size_t size, size_t sigops) const
+{
+    const auto sigops_limit = (size / one_million_bytes_block + 1) *
+        sigops_per_million_bytes;
+
+    return size <= max_template_size_ && sigops <= sigops_limit;
+}
+
+// The entry is also added to the descendant aggregates of each ancestor.
+void transaction_pool::add_ancestors(handle entry)
+{
+    auto& value = store_.get(entry);
+    auto size = value.size();
+    auto fees = value.fees();
+    auto sigops = value.sigops();
+    const auto list = ancestors(entry);
+
+    for (const auto ancestor: list)
+    {
+        auto& next = store_.get(ancestor);
+        size += next.size();
+        fees += next.fees();
+        sigops += next.sigops();
+
+        eviction_.erase(ancestor);
+        next.set_descendants(next.descendant_count() + 1,
+            next.descendant_size() + value.size(),
+            next.descendant_fees() + value.fees());
+        eviction_.insert(ancestor);
+    }
+
+    value.set_ancestors(list.size() + 1, size, fees, sigops);
+}
+
+// Evict the package (with descendants) of lowest descendant feerate until
+// the pool is within capacity, raising the minimum feerate above each.
+void transaction_pool::evict(hash_list& out_evicted)
+{
+    const auto now = std::time(nullptr);
+
+    while (capacity_ != 0 && bytes_ > capacity_ && !eviction_.empty())
+    {
+        const auto lowest = *eviction_.begin();
+        const auto& value = store_.get(lowest);
+        const auto package_fee = value.descendant_fees() * 1000 /
+            value.descendant_size();
+
+        minimum_fee_ = std::max(decayed_minimum_fee(now),
+            package_fee + incremental_fee);
+        minimum_fee_time_ = now;
+
+        for (const auto descendant: descendants(lowest))
+            out_evicted.push_back(store_.get(descendant).hash());
+
+        out_evicted.push_back(value.hash());
+        remove_conflict(lowest);
+    }
+}
+
+// The minimum halves over the halflife, which is shortened while the pool is
+// below half (or a quarter) of its capacity.
+uint64_t transaction_pool::decayed_minimum_fee(std::time_t now) const
+{
+    if (minimum_fee_ == 0)
+        return 0;
+
+    auto halflife = minimum_fee_halflife;
+
+    if (bytes_ < capacity_ / 4)
+        halflife /= 4;
+    else if (bytes_ < capacity_ / 2)
+        halflife /= 2;
+
+    const auto elapsed = now > minimum_fee_time_ ?
+        static_cast<double>(now - minimum_fee_time_) : 0.0;
+    const auto fee = minimum_fee_ / std::pow(2.0, elapsed / halflife);
+
+    return fee < incremental_fee / 2 ? 0 : static_cast<uint64_t>(fee);
+}
+
+// The confirmed entry is no longer an ancestor of any pooled entry.
+// Erasing the entry from the store anchors its children. Pooled ancestors
+// of the entry are confirmed by the same block and removed before it.
+void transaction_pool::remove_confirmed(handle entry)
+{
+    const auto& value = store_.get(entry);
+
+    for (const auto descendant: descendants(entry))
+    {
+        auto& next = store_.get(descendant);
+        index_.erase(descendant);
+        next.set_ancestors(next.ancestor_count() - 1,
+            next.ancestor_size() - value.size(),
+            next.ancestor_fees() - value.fees(),
+            next.ancestor_sigops() - value.sigops());
+        index_.insert(descendant);
+    }
+
+    erase(entry);
+}
+
+// The descendants of a conflict spend its outputs, so are also invalid.
+// Erasing each entry from the store clears its links, so entries are erased
+// deepest first (a descendant has more ancestors than any of its ancestors),
+// leaving each ancestor reachable while its descendant aggregates are reduced.
+void transaction_pool::remove_conflict(handle entry)
+{
+    auto removed = descendants(entry);
+    removed.push_back(entry);
+
+    std::sort(removed.begin(), removed.end(),
+        [this](handle left, handle right)
+        {
+            return store_.get(left).ancestor_count() >
+                store_.get(right).ancestor_count();
+        });
+
+    for (const auto item: removed)
+        erase(item);
+}
+
+// The entry is unindexed before the store releases its slot. Descendants
+// of the entry are removed first or are anchored, so only the entry itself
+// is removed from the descendant aggregates of its ancestors.
+void transaction_pool::erase(handle entry)
+{
+    const auto& value = store_.get(entry);
+
+    for (const auto ancestor: ancestors(entry))
+    {
+        auto& next = store_.get(ancestor);
+        eviction_.erase(ancestor);
+        next.set_descendants(next.descendant_count() - 1,
+            next.descendant_size() - value.size(),
+            next.descendant_fees() - value.fees());
+        eviction_.insert(ancestor);
+    }
+
+    index_.erase(entry);
+    eviction_.erase(entry);
+    entries_.erase(value.hash());
+    bytes_ -= value.size();
+
+    const auto bucket = buckets_.find(feerate(value));
+
+    if (bucket != buckets_.end())
+    {
+        bucket->second.erase(entry);
+
+        if (bucket->second.empty())
+            buckets_.erase(bucket);
+    }
+
+    for (const auto& input: value.transaction()->inputs())
+    {
+        const auto it = spenders_.find(input.previous_output());
+
+        if (it != spenders_.end() && it->second == entry)
+            spenders_.erase(it);
+    }
+
+    store_.erase(entry);
+}
+
+// The entry's own feerate, in satoshis per kilobyte (as in fee filters).
+uint64_t transaction_pool::feerate(const transaction_entry& entry)
+{
+    return entry.size() == 0 ? 0 : entry.fees() * 1000 / entry.size();
+}
+
+transaction_pool::handles transaction_pool::ancestors(handle entry) const
+{
+    handles out;
+    handles pending;
+    std::unordered_set<handle> visited;
+    store_.parents(entry, pending);
+
+    while (!pending.empty())
+    {
+        const auto next = pending.back();
+        pending.pop_back();
+
+        if (!visited.insert(next).second)
+            continue;
+
+        out.push_back(next);
+        store_.parents(next, pending);
+    }
+
+    return out;
+}
+
+transaction_pool::handles transaction_pool::descendants(handle entry) const
+{
+    handles out;
+    handles pending;
+    std::unordered_set<handle> visited;
+    store_.children(entry, pending);
+
+    while (!pending.empty())
+    {
+        const auto next = pending.back();
+        pending.pop_back();
+
+        if (!visited.insert(next).second)
+            continue;
+
+        out.push_back(next);
+        store_.children(next, pending);
+    }
+
+    return out;
+}
+
+bool transaction_pool::score_compare::operator()(handle left,
+    handle right) const
+{
+    const auto& left_entry = store->get(left);
+    const auto& right_entry = store->get(right);
+    const auto left_score = left_entry.ancestor_score();
+    const auto right_score = right_entry.ancestor_score();
+
+    if (left_score != right_score)
+        return left_score > right_score;
+
+    return left_entry.hash() < right_entry.hash();
+}
+
+bool transaction_pool::eviction_compare::operator()(handle left,
+    handle right) const
+{
+    const auto& left_entry = store->get(left);
+    const auto& right_entry = store->get(right);
+    const auto left_score = left_entry.descendant_score();
+    const auto right_score = right_entry.descendant_score();
+
+    if (left_score != right_score)
+        return left_score < right_score;
+
+    return left_entry.hash() < right_entry.hash();
 }
 
 } // namespace blockchain
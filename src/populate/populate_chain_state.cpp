@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 #include <bitcoin/bitcoin.hpp>
 #include <bitcoin/blockchain/define.hpp>
 #include <bitcoin/blockchain/interface/fast_chain.hpp>
@@ -77,14 +78,87 @@ bool populate_chain_state::get_block_hash(hash_digest& out_hash, size_t height,
         fast_chain_.get_block_hash(out_hash, height);
 }
 
-bool populate_chain_state::populate_bits(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch) const {
-    auto& bits = data.bits.ordered;
-    bits.resize(map.bits.count);
-    auto height = map.bits.high - map.bits.count;
+// Values are copied from the previous window where the heights overlap, so an
+// extension of the previously populated chain reads only the new heights.
+template <typename Reader>
+static bool populate_window(std::vector<uint32_t>& out, size_t high,
+    size_t count, const std::vector<uint32_t>* previous, size_t previous_high,
+    Reader read)
+{
+    out.resize(count);
+    auto height = high - count;
+
+    for (auto& value: out)
+    {
+        ++height;
 
-    for (auto& bit: bits)
-        if (!get_bits(bit, ++height, branch))
+        if (previous != nullptr && height <= previous_high &&
+            previous_high - height < previous->size())
+        {
+            value = (*previous)[previous->size() - 1 - (previous_high - height)];
+            continue;
+        }
+
+        if (!read(value, height))
             return false;
+    }
+
+    return true;
+}
+
+populate_chain_state::window_ptr populate_chain_state::get_window(
+    size_t height, branch::const_ptr branch) const
+{
+    window_ptr previous;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+    previous = window_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The previous parent must not be above this parent, since the store may
+    // not be on this branch above the branch top.
+    if (!previous || previous->height > height)
+        return{};
+
+    // Previous values are valid if the previous parent is in this chain.
+    hash_digest hash;
+    if (!get_block_hash(hash, previous->height - 1, branch) ||
+        hash != previous->parent)
+        return{};
+
+    return previous;
+}
+
+void populate_chain_state::set_window(const chain_state::data& data,
+    const chain_state::map& map, branch::const_ptr branch) const
+{
+    hash_digest parent;
+    if (data.height == 0 || !get_block_hash(parent, data.height - 1, branch))
+        return;
+
+    const auto current = std::make_shared<const window>(
+        window{ data.height, parent, map, data });
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+    window_ = current;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool populate_chain_state::populate_bits(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch, window_ptr previous) const {
+    const auto read = [&](uint32_t& out, size_t height)
+    {
+        return get_bits(out, height, branch);
+    };
+
+    if (!populate_window(data.bits.ordered, map.bits.high, map.bits.count,
+        previous ? &previous->values.bits.ordered : nullptr,
+        previous ? previous->ranges.bits.high : 0, read))
+        return false;
 
     if (is_transaction_pool(branch))
     {
@@ -96,14 +170,17 @@ bool populate_chain_state::populate_bits(chain_state::data& data, const chain_st
     return get_bits(data.bits.self, map.bits_self, branch);
 }
 
-bool populate_chain_state::populate_versions(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch) const {
-    auto& versions = data.version.ordered;
-    versions.resize(map.version.count);
-    auto height = map.version.high - map.version.count;
+bool populate_chain_state::populate_versions(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch, window_ptr previous) const {
+    const auto read = [&](uint32_t& out, size_t height)
+    {
+        return get_version(out, height, branch);
+    };
 
-    for (auto& version: versions)
-        if (!get_version(version, ++height, branch))
-            return false;
+    if (!populate_window(data.version.ordered, map.version.high,
+        map.version.count,
+        previous ? &previous->values.version.ordered : nullptr,
+        previous ? previous->ranges.version.high : 0, read))
+        return false;
 
     if (is_transaction_pool(branch))
     {
@@ -114,15 +191,19 @@ bool populate_chain_state::populate_versions(chain_state::data& data, const chai
     return get_version(data.version.self, map.version_self, branch);
 }
 
-bool populate_chain_state::populate_timestamps(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch) const {
+bool populate_chain_state::populate_timestamps(chain_state::data& data, const chain_state::map& map, branch::const_ptr branch, window_ptr previous) const {
     data.timestamp.retarget = unspecified;
-    auto& timestamps = data.timestamp.ordered;
-    timestamps.resize(map.timestamp.count);
-    auto height = map.timestamp.high - map.timestamp.count;
 
-    for (auto& timestamp: timestamps)
-        if (!get_timestamp(timestamp, ++height, branch))
-            return false;
+    const auto read = [&](uint32_t& out, size_t height)
+    {
+        return get_timestamp(out, height, branch);
+    };
+
+    if (!populate_window(data.timestamp.ordered, map.timestamp.high,
+        map.timestamp.count,
+        previous ? &previous->values.timestamp.ordered : nullptr,
+        previous ? previous->ranges.timestamp.high : 0, read))
+        return false;
 
     // Retarget is required if timestamp_retarget is not unrequested.
     if (map.timestamp_retarget != chain_state::map::unrequested &&
@@ -183,20 +264,20 @@ bool populate_chain_state::populate_bip9_bit1(chain_state::data& data,
 bool populate_chain_state::populate_all(chain_state::data& data,
     branch::const_ptr branch) const
 {
-    // Critical Section
-    ///////////////////////////////////////////////////////////////////////////
-    unique_lock lock(mutex_);
-
     // Construct a map to inform chain state data population.
     auto const map = chain_state::get_map(data.height, checkpoints_, configured_forks_);
+    auto const previous = get_window(data.height, branch);
+
+    if (!populate_bits(data, map, branch, previous) ||
+        !populate_versions(data, map, branch, previous) ||
+        !populate_timestamps(data, map, branch, previous) ||
+        !populate_collision(data, map, branch) ||
+        !populate_bip9_bit0(data, map, branch) ||
+        !populate_bip9_bit1(data, map, branch))
+        return false;
 
-    return (populate_bits(data, map, branch) &&
-        populate_versions(data, map, branch) &&
-        populate_timestamps(data, map, branch) &&
-        populate_collision(data, map, branch) &&
-        populate_bip9_bit0(data, map, branch) &&
-        populate_bip9_bit1(data, map, branch));
-    ///////////////////////////////////////////////////////////////////////////
+    set_window(data, map, branch);
+    return true;
 }
 
 chain_state::ptr populate_chain_state::populate() const {
@@ -31,6 +31,9 @@ settings::settings()
   , minimum_output_satoshis(500)
   , notify_limit_hours(24)
   , reorganization_limit(256)
+  , block_cache_capacity(128 * 1024 * 1024)
+  , extra_transaction_capacity(100)
+  , transaction_pool_capacity(300 * 1000 * 1000)
   , allow_collisions(true)
   , easy_blocks(false)
   , retarget(true)
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(block_cache_tests)
+
+static block_const_ptr make_cached_block(uint32_t id)
+{
+    return std::make_shared<const message::block>(message::block
+    {
+        chain::header{ id, null_hash, null_hash, 0, 0, 0 }, {}
+    });
+}
+
+// The serialized size of a block without transactions (header and count).
+static const size_t empty_block_size = 81;
+
+// add
+
+BOOST_AUTO_TEST_CASE(block_cache__add__zero_capacity__not_cached)
+{
+    block_cache instance(0);
+    instance.add(make_cached_block(42), 0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__oversized__not_cached)
+{
+    block_cache instance(empty_block_size - 1);
+    instance.add(make_cached_block(42), 0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__capacity__expected_bytes)
+{
+    block_cache instance(2 * empty_block_size);
+    instance.add(make_cached_block(0), 0);
+    instance.add(make_cached_block(1), 1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 2 * empty_block_size);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__over_capacity__evicts_least_recent)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    const auto block1 = make_cached_block(1);
+    const auto block2 = make_cached_block(2);
+    instance.add(block0, 0);
+    instance.add(block1, 1);
+
+    // Touch block0 so that block1 is the least recently used.
+    BOOST_REQUIRE(instance.get(0) == block0);
+    instance.add(block2, 2);
+
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(instance.get(0) == block0);
+    BOOST_REQUIRE(!instance.get(1));
+    BOOST_REQUIRE(instance.get(2) == block2);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__same_height__replaced)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    const auto block1 = make_cached_block(1);
+    instance.add(block0, 5);
+    instance.add(block1, 5);
+
+    size_t height;
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.get(5) == block1);
+    BOOST_REQUIRE(!instance.get(height, block0->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__generation_unchanged__cached)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    const auto generation = instance.generation();
+    instance.add(make_cached_block(1), 1);
+    instance.add(block0, 0, generation);
+    BOOST_REQUIRE(instance.get(0) == block0);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__removed_since_generation__not_cached)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    instance.add(block0, 0);
+    const auto generation = instance.generation();
+
+    // The block is reorganized out while it is read for the fetch.
+    instance.remove(block0->hash());
+    instance.add(block0, 0, generation);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(!instance.get(0));
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__add__cleared_since_generation__not_cached)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto generation = instance.generation();
+    instance.clear();
+    instance.add(make_cached_block(0), 0, generation);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(block_cache__remove__cached__not_found)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    instance.add(block0, 0);
+    instance.remove(block0->hash());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+    BOOST_REQUIRE(!instance.get(0));
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(block_cache__clear__populated__empty)
+{
+    block_cache instance(2 * empty_block_size);
+    instance.add(make_cached_block(0), 0);
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+}
+
+// get
+
+BOOST_AUTO_TEST_CASE(block_cache__get__hash__expected_height)
+{
+    block_cache instance(2 * empty_block_size);
+    const auto block0 = make_cached_block(0);
+    instance.add(block0, 42);
+
+    size_t height = 0;
+    BOOST_REQUIRE(instance.get(height, block0->hash()) == block0);
+    BOOST_REQUIRE_EQUAL(height, 42u);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache__get__hit_and_miss__counted)
+{
+    block_cache instance(2 * empty_block_size);
+    instance.add(make_cached_block(0), 0);
+    BOOST_REQUIRE(instance.get(0));
+    BOOST_REQUIRE(!instance.get(1));
+    BOOST_REQUIRE(!instance.get(2));
+    BOOST_REQUIRE_EQUAL(instance.hits(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,9 +18,11 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <future>
 #include <memory>
 #include <string>
+#include <vector>
 #include <bitcoin/blockchain.hpp>
 
 using namespace bc;
@@ -59,12 +61,15 @@ using namespace boost::filesystem;
     std::string(boost::unit_test::framework::current_test_case().p_name)
 
 #define START_BLOCKCHAIN(name, flush) \
+    START_BLOCKCHAIN_SETTINGS(name, flush, blockchain::settings{})
+
+#define START_BLOCKCHAIN_SETTINGS(name, flush, settings) \
     threadpool pool; \
     database::settings database_settings; \
     database_settings.flush_writes = flush; \
     database_settings.directory = TEST_NAME; \
     BOOST_REQUIRE(create_database(database_settings)); \
-    blockchain::settings blockchain_settings; \
+    const blockchain::settings blockchain_settings = settings; \
     block_chain name(pool, blockchain_settings, database_settings); \
     BOOST_REQUIRE(name.start())
 
@@ -529,6 +534,65 @@ BOOST_AUTO_TEST_CASE(block_chain__fetch_block1__not_exists__error_not_found)
     BOOST_REQUIRE_EQUAL(fetch_block_by_height_result(instance, block1, 1), error::not_found);
 }
 
+// A block (not valid) on the given parent with the given number of distinct
+// transactions.
+static block_const_ptr make_block(block_const_ptr parent, size_t count)
+{
+    chain::transaction::list txs;
+    txs.reserve(count);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        chain::input::list inputs;
+        inputs.emplace_back(chain::output_point(null_hash,
+            chain::point::null_index), chain::script{}, max_input_sequence);
+
+        chain::output::list outputs;
+        outputs.emplace_back(index, chain::script{});
+
+        txs.emplace_back(1, static_cast<uint32_t>(index), std::move(inputs),
+            std::move(outputs));
+    }
+
+    const auto& header = parent->header();
+    return std::make_shared<const message::block>(chain::header
+    {
+        header.version(), parent->hash(), null_hash,
+        header.timestamp() + 600, header.bits(), 42
+    }, std::move(txs));
+}
+
+// Blocks of at least 1000 transactions are read concurrently.
+BOOST_AUTO_TEST_CASE(block_chain__fetch_block1__below_parallel_threshold__success)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block = make_block(NEW_BLOCK(1), 999);
+    BOOST_REQUIRE(instance.insert(block, 1));
+    BOOST_REQUIRE_EQUAL(fetch_block_by_height_result(instance, block, 1), error::success);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_block1__parallel_threshold__success_before_return)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block = make_block(NEW_BLOCK(1), 1000);
+    BOOST_REQUIRE(instance.insert(block, 1));
+
+    auto invoked = false;
+    const auto handler = [&](code ec, block_const_ptr result, size_t height)
+    {
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        BOOST_REQUIRE_EQUAL(height, 1u);
+        BOOST_REQUIRE(*result == *block);
+        invoked = true;
+    };
+
+    // The handler is invoked before the fetch returns.
+    instance.fetch_block(1, true, handler);
+    BOOST_REQUIRE(invoked);
+}
+
 static int fetch_block_by_hash_result(block_chain& instance,
     block_const_ptr block, size_t height)
 {
@@ -566,6 +630,228 @@ BOOST_AUTO_TEST_CASE(block_chain__fetch_block2__not_exists__error_not_found)
     BOOST_REQUIRE_EQUAL(fetch_block_by_hash_result(instance, block1, 1), error::not_found);
 }
 
+// fetch_blocks
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_blocks__exist__in_height_order)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+    BOOST_REQUIRE(instance.insert(block3, 3));
+
+    std::vector<size_t> heights;
+    const auto handler = [&](const code& ec, block_const_ptr block,
+        size_t height)
+    {
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        BOOST_REQUIRE(block);
+        heights.push_back(height);
+        return true;
+    };
+
+    instance.fetch_blocks(1, 3, true, 1, handler);
+    BOOST_REQUIRE_EQUAL(heights.size(), 3u);
+    BOOST_REQUIRE_EQUAL(heights[0], 1u);
+    BOOST_REQUIRE_EQUAL(heights[1], 2u);
+    BOOST_REQUIRE_EQUAL(heights[2], 3u);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_blocks__handler_false__stopped)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+
+    size_t calls = 0;
+    const auto handler = [&](const code&, block_const_ptr, size_t)
+    {
+        ++calls;
+        return false;
+    };
+
+    instance.fetch_blocks(1, 2, true, 2, handler);
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_blocks__not_exists__error_not_found)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    std::vector<code> codes;
+    const auto handler = [&](const code& ec, block_const_ptr, size_t)
+    {
+        codes.push_back(ec);
+        return true;
+    };
+
+    instance.fetch_blocks(1, 3, true, 1, handler);
+    BOOST_REQUIRE_EQUAL(codes.size(), 2u);
+    BOOST_REQUIRE_EQUAL(codes[0], error::success);
+    BOOST_REQUIRE_EQUAL(codes[1], error::not_found);
+}
+
+// fetch_block_raw
+
+static data_chunk fetch_block_raw_result(block_chain& instance, size_t height,
+    bool witness)
+{
+    std::promise<data_chunk> promise;
+    const auto handler = [&promise](code ec, data_chunk data, size_t)
+    {
+        promise.set_value(ec ? data_chunk{} : data);
+    };
+    instance.fetch_block_raw(height, witness, handler);
+    return promise.get_future().get();
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__fetch_block_raw__non_witness__block_data)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(fetch_block_raw_result(instance, 1, false) == block1->to_data(false));
+    BOOST_REQUIRE(fetch_block_raw_result(instance, 1, true) == block1->to_data(true));
+}
+
+#ifndef BITPRIM_CURRENCY_BCH
+BOOST_AUTO_TEST_CASE(block_chain__fetch_block_raw__witness__block_data)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto& header = block1->header();
+    const chain::witness witness(data_stack{ { 0x01, 0x02 }, { 0x03 } });
+
+    chain::input::list inputs;
+    const auto& coinbase = block1->transactions().front();
+    inputs.emplace_back(chain::output_point(coinbase.hash(), 0),
+        chain::script{}, witness, max_input_sequence);
+
+    chain::output::list outputs;
+    outputs.emplace_back(42, chain::script(
+        chain::script::to_pay_key_hash_pattern(null_short_hash)));
+
+    // The block is not valid, it has only the witness transaction.
+    chain::transaction::list txs;
+    txs.emplace_back(1, 0, std::move(inputs), std::move(outputs));
+
+    const auto block2 = std::make_shared<const message::block>(chain::header
+    {
+        header.version(), block1->hash(), null_hash,
+        header.timestamp() + 600, header.bits(), 42
+    }, std::move(txs));
+
+    BOOST_REQUIRE(instance.insert(block2, 2));
+    BOOST_REQUIRE(fetch_block_raw_result(instance, 2, false) == block2->to_data(false));
+    BOOST_REQUIRE(fetch_block_raw_result(instance, 2, true) == block2->to_data(true));
+}
+#endif
+
+// for_each_transaction_view
+
+BOOST_AUTO_TEST_CASE(block_chain__for_each_transaction_view__exists__expected)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    const auto& coinbase = block1->transactions().front();
+
+    size_t calls = 0;
+    const auto handler = [&](const code& ec, size_t height,
+        const transaction_view& view)
+    {
+        ++calls;
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        BOOST_REQUIRE(view);
+        BOOST_REQUIRE_EQUAL(height, 1u);
+        BOOST_REQUIRE_EQUAL(view.height(), 1u);
+        BOOST_REQUIRE_EQUAL(view.position(), 0u);
+        BOOST_REQUIRE(view.hash() == coinbase.hash());
+        BOOST_REQUIRE(view.output(0) == coinbase.outputs().front());
+        BOOST_REQUIRE(view.transaction() == coinbase);
+    };
+
+    instance.for_each_transaction_view(1, 1, true, handler);
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+// for_each_transaction_parallel
+
+BOOST_AUTO_TEST_CASE(block_chain__for_each_transaction_parallel__ordered__height_order)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(1), 1));
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(2), 2));
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(3), 3));
+
+    std::vector<size_t> heights;
+    const auto handler = [&](const code& ec, size_t height,
+        const chain::transaction&)
+    {
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        heights.push_back(height);
+        return true;
+    };
+
+    instance.for_each_transaction_parallel(0, 3, true, true, handler);
+    BOOST_REQUIRE_EQUAL(heights.size(), 4u);
+    BOOST_REQUIRE_EQUAL(heights[0], 0u);
+    BOOST_REQUIRE_EQUAL(heights[1], 1u);
+    BOOST_REQUIRE_EQUAL(heights[2], 2u);
+    BOOST_REQUIRE_EQUAL(heights[3], 3u);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__for_each_transaction_parallel__handler_false__stopped)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(1), 1));
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(2), 2));
+
+    size_t calls = 0;
+    const auto handler = [&](const code&, size_t, const chain::transaction&)
+    {
+        ++calls;
+        return false;
+    };
+
+    instance.for_each_transaction_parallel(0, 2, true, true, handler);
+    BOOST_REQUIRE_EQUAL(calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__for_each_transaction_non_coinbase_parallel__coinbase_only__none)
+{
+    START_BLOCKCHAIN(instance, false);
+
+    BOOST_REQUIRE(instance.insert(NEW_BLOCK(1), 1));
+
+    std::atomic<size_t> calls(0);
+    const auto handler = [&](const code&, size_t, const chain::transaction&)
+    {
+        ++calls;
+        return true;
+    };
+
+    instance.for_each_transaction_non_coinbase_parallel(0, 1, true, false,
+        handler);
+    BOOST_REQUIRE_EQUAL(calls.load(), 0u);
+}
+
 // fetch_block_header
 
 static int fetch_block_header_by_height_result(block_chain& instance,
@@ -805,6 +1091,451 @@ BOOST_AUTO_TEST_CASE(block_chain__fetch_locator_block_headers__limited__sequenti
     BOOST_REQUIRE_EQUAL(fetch_locator_block_headers(instance, locator, null_hash, 2), error::success);
 }
 
+// chain_state
+
+// A block (not valid) whose parent is the given block.
+static block_const_ptr make_child(block_const_ptr parent, uint32_t nonce)
+{
+    const auto& header = parent->header();
+    return std::make_shared<const message::block>(chain::header
+    {
+        header.version(), parent->hash(), null_hash,
+        header.timestamp() + 600, header.bits(), nonce
+    }, chain::transaction::list{});
+}
+
+static branch::const_ptr make_branch(block_const_ptr block, size_t height)
+{
+    const auto value = std::make_shared<branch>(height - 1);
+    BOOST_REQUIRE(value->push_front(block));
+    return value;
+}
+
+static void require_equal(chain::chain_state::ptr left,
+    chain::chain_state::ptr right)
+{
+    BOOST_REQUIRE(left);
+    BOOST_REQUIRE(right);
+    BOOST_REQUIRE_EQUAL(left->height(), right->height());
+    BOOST_REQUIRE_EQUAL(left->enabled_forks(), right->enabled_forks());
+    BOOST_REQUIRE_EQUAL(left->minimum_version(), right->minimum_version());
+    BOOST_REQUIRE_EQUAL(left->median_time_past(), right->median_time_past());
+    BOOST_REQUIRE_EQUAL(left->work_required(), right->work_required());
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__chain_state__siblings_and_cousin__uncached_states)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+    BOOST_REQUIRE(instance.insert(block3, 3));
+
+    // Two children of the same parent, then a child of a different parent.
+    const auto branches =
+    {
+        make_branch(make_child(block3, 1), 4),
+        make_branch(make_child(block3, 2), 4),
+        make_branch(make_child(block2, 3), 3)
+    };
+
+    const auto pool = instance.chain_state();
+
+    for (const auto& fork: branches)
+    {
+        // A new populator has no windows of a previous population.
+        const populate_chain_state uncached(instance, blockchain_settings);
+        require_equal(instance.chain_state(fork),
+            uncached.populate(pool, fork));
+    }
+}
+
+// reorganize
+
+BOOST_AUTO_TEST_CASE(block_chain__reorganize__shorter_branch__branch_work_from_fork_point)
+{
+    START_BLOCKCHAIN(instance, false);
+    dispatcher dispatch(pool, TEST_NAME);
+
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+    BOOST_REQUIRE(instance.insert(block3, 3));
+
+    // Replace blocks 2 and 3 with a single block on block 1.
+    const auto child = make_child(block1, 42);
+    const auto state = instance.chain_state(make_branch(child, 2));
+    child->validation.state = state;
+    child->header().validation.median_time_past = state->median_time_past();
+
+    const auto incoming = std::make_shared<const block_const_ptr_list>(
+        block_const_ptr_list{ child });
+    const auto outgoing = std::make_shared<block_const_ptr_list>();
+
+    std::promise<code> promise;
+    const auto handler = [&promise](code ec)
+    {
+        promise.set_value(ec);
+    };
+
+    const config::checkpoint fork_point(block1->hash(), 1);
+    instance.reorganize(fork_point, incoming, outgoing, dispatch, handler);
+    BOOST_REQUIRE_EQUAL(promise.get_future().get(), error::success);
+    BOOST_REQUIRE_EQUAL(outgoing->size(), 2u);
+
+    // The work from the fork point covers the fork block and the new top only.
+    uint256_t work;
+    uint256_t maximum(max_uint64);
+    BOOST_REQUIRE(instance.get_branch_work(work, maximum, 1));
+    BOOST_REQUIRE_EQUAL(work, 0x0000000200020002);
+
+    BOOST_REQUIRE(instance.get_branch_work(work, maximum, 2));
+    BOOST_REQUIRE_EQUAL(work, 0x0000000100010001);
+
+    hash_digest hash;
+    BOOST_REQUIRE(instance.get_block_hash(hash, 2));
+    BOOST_REQUIRE(hash == child->hash());
+    BOOST_REQUIRE(!instance.get_block_hash(hash, 3));
+}
+
+// add_to_chosen_list
+
+static const short_hash pool_test_key_hash
+{
+    {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+        0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14
+    }
+};
+
+// Spend the coinbase of the block to the test address, paying the given fee.
+static transaction_const_ptr spend_coinbase(block_const_ptr block,
+    uint64_t fee)
+{
+    const auto& coinbase = block->transactions().front();
+    const auto& output = coinbase.outputs().front();
+
+    chain::output_point point(coinbase.hash(), 0);
+    point.validation.cache = output;
+
+    chain::input::list inputs;
+    inputs.emplace_back(std::move(point), chain::script{}, 0);
+
+    chain::output::list outputs;
+    outputs.emplace_back(output.value() - fee, chain::script(
+        chain::script::to_pay_key_hash_pattern(pool_test_key_hash)));
+
+    return std::make_shared<const message::transaction>(
+        chain::transaction(1, 0, std::move(inputs), std::move(outputs)));
+}
+
+static code push_transaction(block_chain& instance, dispatcher& dispatch,
+    transaction_const_ptr tx)
+{
+    std::promise<code> promise;
+    const auto handler = [&promise](code ec)
+    {
+        promise.set_value(ec);
+    };
+
+    tx->validation.state = instance.chain_state();
+    instance.push(tx, dispatch, handler);
+    return promise.get_future().get();
+}
+
+static bool is_served(const block_chain& instance, transaction_const_ptr tx)
+{
+    const auto address = wallet::payment_address(pool_test_key_hash,
+        wallet::payment_address::mainnet_p2kh).encoded();
+    const auto hash = encode_hash(tx->hash());
+
+    for (const auto& summary: instance.get_mempool_transactions(address,
+        false, false))
+        if (summary.hash() == hash)
+            return true;
+
+    return false;
+}
+
+static bool is_stored(const block_chain& instance, transaction_const_ptr tx)
+{
+    std::promise<code> promise;
+    const auto handler = [&promise](code ec, transaction_const_ptr)
+    {
+        promise.set_value(ec);
+    };
+
+    instance.fetch_unconfirmed_transaction(tx->hash(), handler);
+    return promise.get_future().get() == error::success;
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__add_to_chosen_list__over_capacity__evicted_not_served)
+{
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    const auto block3 = NEW_BLOCK(3);
+    const auto low = spend_coinbase(block1, 100);
+    const auto high = spend_coinbase(block2, 300);
+    const auto mid = spend_coinbase(block3, 200);
+
+    blockchain::settings settings;
+    settings.transaction_pool_capacity = 2 * low->serialized_size();
+    START_BLOCKCHAIN_SETTINGS(instance, false, settings);
+    dispatcher dispatch(pool, TEST_NAME);
+
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+    BOOST_REQUIRE(instance.insert(block3, 3));
+
+    for (const auto tx: { low, high, mid })
+    {
+        BOOST_REQUIRE_EQUAL(push_transaction(instance, dispatch, tx),
+            error::success);
+        BOOST_REQUIRE(instance.add_to_chosen_list(tx));
+    }
+
+    // The lowest feerate transaction is evicted from the pool and indexes.
+    BOOST_REQUIRE(!is_served(instance, low));
+    BOOST_REQUIRE(is_served(instance, high));
+    BOOST_REQUIRE(is_served(instance, mid));
+
+    // The evicted transaction is also removed from the store.
+    BOOST_REQUIRE(!is_stored(instance, low));
+    BOOST_REQUIRE(is_stored(instance, high));
+    BOOST_REQUIRE(is_stored(instance, mid));
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__add_to_chosen_list__pooled_double_spend__false)
+{
+    START_BLOCKCHAIN(instance, false);
+    dispatcher dispatch(pool, TEST_NAME);
+
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto first = spend_coinbase(block1, 100);
+    BOOST_REQUIRE_EQUAL(push_transaction(instance, dispatch, first),
+        error::success);
+    BOOST_REQUIRE(instance.add_to_chosen_list(first));
+
+    // The pool rejects the conflict and a repeat is already pooled.
+    BOOST_REQUIRE(!instance.add_to_chosen_list(spend_coinbase(block1, 200)));
+    BOOST_REQUIRE(instance.add_to_chosen_list(first));
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__start__stored_unconfirmed__pool_rebuilt)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    const auto first = spend_coinbase(block1, 100);
+
+    {
+        dispatcher dispatch(pool, TEST_NAME);
+        BOOST_REQUIRE_EQUAL(push_transaction(instance, dispatch, first),
+            error::success);
+        BOOST_REQUIRE(instance.add_to_chosen_list(first));
+    }
+
+    BOOST_REQUIRE(instance.close());
+
+    // A new instance has an empty pool until it is rebuilt from the store.
+    block_chain restarted(pool, blockchain_settings, database_settings);
+    BOOST_REQUIRE(restarted.start());
+
+    // The stored transaction is pooled again, so its conflict is rejected.
+    BOOST_REQUIRE(is_served(restarted, first));
+    BOOST_REQUIRE(!restarted.add_to_chosen_list(spend_coinbase(block1, 200)));
+}
+
+// fill_tx_list_from_mempool
+
+BOOST_AUTO_TEST_CASE(block_chain__fill_tx_list_from_mempool__pooled__filled)
+{
+    START_BLOCKCHAIN(instance, false);
+    dispatcher dispatch(pool, TEST_NAME);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto tx = spend_coinbase(block1, 100);
+    BOOST_REQUIRE_EQUAL(push_transaction(instance, dispatch, tx),
+        error::success);
+
+    // The coinbase is prefilled (slot zero), the spend is slot one.
+    const auto block = message::compact_block::factory_from_block(
+        message::block(block1->header(), { block1->transactions().front(),
+            *tx }));
+    const auto header_hash = hash(block);
+    const auto k0 = from_little_endian_unsafe<uint64_t>(header_hash.begin());
+    const auto k1 = from_little_endian_unsafe<uint64_t>(
+        header_hash.begin() + sizeof(uint64_t));
+
+#ifdef BITPRIM_CURRENCY_BCH
+    const auto id_hash = tx->hash();
+#else
+    const auto id_hash = tx->hash(true);
+#endif
+
+    const std::unordered_map<uint64_t, uint16_t> short_ids
+    {
+        { short_id_table::short_id(k0, k1, id_hash), 1 }
+    };
+
+    size_t count = 0;
+    std::vector<chain::transaction> txn_available(2);
+    instance.fill_tx_list_from_mempool(block, count, txn_available,
+        short_ids);
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE(!txn_available[0].is_valid());
+    BOOST_REQUIRE(txn_available[1].hash() == tx->hash());
+}
+
+// get_gbt_snapshot
+
+static bool add_chosen(block_chain& instance, transaction_const_ptr tx)
+{
+    tx->validation.state = instance.chain_state();
+    return instance.add_to_chosen_list(tx);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__get_gbt_snapshot__unchanged__reused)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto empty = instance.get_gbt_snapshot();
+    BOOST_REQUIRE(instance.get_gbt_snapshot() == empty);
+
+    BOOST_REQUIRE(add_chosen(instance, spend_coinbase(block1, 100)));
+    const auto snapshot = instance.get_gbt_snapshot();
+    BOOST_REQUIRE(snapshot != empty);
+    BOOST_REQUIRE_GT(snapshot->version, empty->version);
+    BOOST_REQUIRE_EQUAL(snapshot->txs.size(), 1u);
+    BOOST_REQUIRE(instance.get_gbt_snapshot() == snapshot);
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__get_gbt_snapshot__same_chosen_list__payload_shared)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto tx = spend_coinbase(block1, 100);
+    BOOST_REQUIRE(add_chosen(instance, tx));
+    const auto first = instance.get_gbt_snapshot();
+    BOOST_REQUIRE_EQUAL(first->payload->size(), tx->serialized_size());
+
+    // A duplicate changes the version but not the chosen list.
+    BOOST_REQUIRE(add_chosen(instance, tx));
+    const auto second = instance.get_gbt_snapshot();
+    BOOST_REQUIRE(second != first);
+    BOOST_REQUIRE(second->payload == first->payload);
+}
+
+// get_template_delta
+
+BOOST_AUTO_TEST_CASE(block_chain__get_template_delta__consecutive__added)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+
+    const auto tx1 = spend_coinbase(block1, 100);
+    const auto tx2 = spend_coinbase(block2, 200);
+    BOOST_REQUIRE(add_chosen(instance, tx1));
+    const auto first = instance.get_gbt_snapshot();
+    BOOST_REQUIRE(add_chosen(instance, tx2));
+    const auto second = instance.get_gbt_snapshot();
+
+    const auto delta = instance.get_template_delta(first->version);
+    BOOST_REQUIRE(!delta.full);
+    BOOST_REQUIRE_EQUAL(delta.from_version, first->version);
+    BOOST_REQUIRE_EQUAL(delta.version, second->version);
+    BOOST_REQUIRE_EQUAL(delta.added.size(), 1u);
+    BOOST_REQUIRE(delta.added.front()->tx_id == tx2->hash());
+    BOOST_REQUIRE(delta.removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__get_template_delta__current__empty)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(add_chosen(instance, spend_coinbase(block1, 100)));
+    const auto snapshot = instance.get_gbt_snapshot();
+
+    const auto delta = instance.get_template_delta(snapshot->version);
+    BOOST_REQUIRE(!delta.full);
+    BOOST_REQUIRE(delta.added.empty());
+    BOOST_REQUIRE(delta.removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__get_template_delta__outside_history__full)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+
+    const auto tx = spend_coinbase(block1, 100);
+    const auto since = instance.get_gbt_snapshot()->version;
+    BOOST_REQUIRE(add_chosen(instance, tx));
+    instance.get_gbt_snapshot();
+
+    // Each publication adds a delta to the (64 deep) history, a duplicate
+    // is not pooled but does change the version.
+    for (size_t publication = 0; publication < 64; ++publication)
+    {
+        BOOST_REQUIRE(add_chosen(instance, tx));
+        instance.get_gbt_snapshot();
+    }
+
+    const auto snapshot = instance.get_gbt_snapshot();
+    const auto delta = instance.get_template_delta(since);
+    BOOST_REQUIRE(delta.full);
+    BOOST_REQUIRE_EQUAL(delta.version, snapshot->version);
+    BOOST_REQUIRE_EQUAL(delta.added.size(), 1u);
+    BOOST_REQUIRE(delta.added.front() == snapshot->txs.front());
+    BOOST_REQUIRE(delta.removed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(block_chain__get_template_delta__mined__removed)
+{
+    START_BLOCKCHAIN(instance, false);
+    const auto block1 = NEW_BLOCK(1);
+    const auto block2 = NEW_BLOCK(2);
+    BOOST_REQUIRE(instance.insert(block1, 1));
+    BOOST_REQUIRE(instance.insert(block2, 2));
+
+    const auto tx1 = spend_coinbase(block1, 100);
+    const auto tx2 = spend_coinbase(block2, 200);
+    BOOST_REQUIRE(add_chosen(instance, tx1));
+    BOOST_REQUIRE(add_chosen(instance, tx2));
+    const auto before = instance.get_gbt_snapshot();
+    BOOST_REQUIRE_EQUAL(before->txs.size(), 2u);
+
+    // A block confirming the first transaction arrives.
+    const auto mined = std::make_shared<const message::block>(
+        chain::header{}, chain::transaction::list{ *tx1 });
+    instance.remove_mined_txs_from_chosen_list(mined);
+
+    const auto after = instance.get_gbt_snapshot();
+    const auto delta = instance.get_template_delta(before->version);
+    BOOST_REQUIRE(!delta.full);
+    BOOST_REQUIRE_EQUAL(delta.version, after->version);
+    BOOST_REQUIRE(delta.added.empty());
+    BOOST_REQUIRE_EQUAL(delta.removed.size(), 1u);
+    BOOST_REQUIRE(delta.removed.front() == tx1->hash());
+    BOOST_REQUIRE_EQUAL(after->txs.size(), 1u);
+    BOOST_REQUIRE(after->txs.front()->tx_id == tx2->hash());
+}
+
 // TODO: fetch_template
 // TODO: fetch_mempool
 // TODO: filter_blocks
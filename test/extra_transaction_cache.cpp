@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(extra_transaction_cache_tests)
+
+static const uint64_t key0 = 0x0706050403020100;
+static const uint64_t key1 = 0x0f0e0d0c0b0a0908;
+
+static transaction_const_ptr make_tx(uint32_t locktime)
+{
+    return std::make_shared<const message::transaction>(
+        chain::transaction(1, locktime, {}, {}));
+}
+
+static uint64_t short_id(transaction_const_ptr tx)
+{
+#ifdef BITPRIM_CURRENCY_BCH
+    return short_id_table::short_id(key0, key1, tx->hash());
+#else
+    return short_id_table::short_id(key0, key1, tx->hash(true));
+#endif
+}
+
+// add
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__add__zero_capacity__empty)
+{
+    extra_transaction_cache instance(0);
+    instance.add(make_tx(1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__add__full__oldest_replaced)
+{
+    extra_transaction_cache instance(2);
+    const auto tx1 = make_tx(1);
+    const auto tx3 = make_tx(3);
+    instance.add(tx1);
+    instance.add(make_tx(2));
+    instance.add(tx3);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+
+    const extra_transaction_cache::short_id_map short_ids
+    {
+        { short_id(tx1), 0 },
+        { short_id(tx3), 1 }
+    };
+
+    size_t count = 0;
+    std::vector<chain::transaction> txn_available(2);
+    instance.fill(txn_available, count, key0, key1, short_ids);
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE(!txn_available[0].is_valid());
+    BOOST_REQUIRE(txn_available[1].hash() == tx3->hash());
+}
+
+// fill
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__fill__matched__hit_counted)
+{
+    extra_transaction_cache instance(10);
+    const auto tx = make_tx(42);
+    instance.add(tx);
+
+    const extra_transaction_cache::short_id_map short_ids
+    {
+        { short_id(make_tx(7)), 0 },
+        { short_id(tx), 1 }
+    };
+
+    size_t count = 0;
+    std::vector<chain::transaction> txn_available(2);
+    instance.fill(txn_available, count, key0, key1, short_ids);
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE(txn_available[1].hash() == tx->hash());
+    BOOST_REQUIRE_EQUAL(instance.hits(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__fill__already_filled__unchanged)
+{
+    extra_transaction_cache instance(10);
+    const auto tx = make_tx(42);
+    instance.add(tx);
+
+    const extra_transaction_cache::short_id_map short_ids
+    {
+        { short_id(tx), 0 }
+    };
+
+    size_t count = 1;
+    std::vector<chain::transaction> txn_available{ *tx };
+    instance.fill(txn_available, count, key0, key1, short_ids);
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE(txn_available[0].hash() == tx->hash());
+    BOOST_REQUIRE_EQUAL(instance.hits(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__fill__third_match__slot_remains_ambiguous)
+{
+    extra_transaction_cache instance(10);
+    const auto tx1 = make_tx(1);
+    const auto tx2 = make_tx(2);
+    const auto tx3 = make_tx(3);
+    instance.add(tx1);
+    instance.add(tx2);
+    instance.add(tx3);
+
+    // Each short id maps to the one slot, as colliding ids would.
+    const extra_transaction_cache::short_id_map short_ids
+    {
+        { short_id(tx1), 0 },
+        { short_id(tx2), 0 },
+        { short_id(tx3), 0 }
+    };
+
+    size_t count = 0;
+    std::vector<chain::transaction> txn_available(1);
+    instance.fill(txn_available, count, key0, key1, short_ids);
+    BOOST_REQUIRE_EQUAL(count, 0u);
+    BOOST_REQUIRE(!txn_available[0].is_valid());
+    BOOST_REQUIRE_EQUAL(instance.hits(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(extra_transaction_cache__fill__prefilled_slot__misses_short_id_slots)
+{
+    extra_transaction_cache instance(10);
+    const auto prefilled = make_tx(1);
+    instance.add(make_tx(42));
+
+    const extra_transaction_cache::short_id_map short_ids
+    {
+        { short_id(make_tx(7)), 1 },
+        { short_id(make_tx(8)), 2 }
+    };
+
+    // The prefilled slot is counted but is not a short id slot.
+    size_t count = 1;
+    std::vector<chain::transaction> txn_available(3);
+    txn_available[0] = *prefilled;
+    instance.fill(txn_available, count, key0, key1, short_ids);
+    BOOST_REQUIRE_EQUAL(count, 1u);
+    BOOST_REQUIRE_EQUAL(instance.hits(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.misses(), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
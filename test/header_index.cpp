@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(header_index_tests)
+
+static chain::header make_header(uint32_t id, const hash_digest& parent)
+{
+    return chain::header{ id, parent, null_hash, id + 1, id + 2, id + 3 };
+}
+
+// push
+
+BOOST_AUTO_TEST_CASE(header_index__push__contiguous__true)
+{
+    header_index instance;
+    const auto header0 = make_header(0, null_hash);
+    const auto header1 = make_header(1, header0.hash());
+    BOOST_REQUIRE(instance.push(header0, 0));
+    BOOST_REQUIRE(instance.push(header1, 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__push__gap__false)
+{
+    header_index instance;
+    BOOST_REQUIRE(!instance.push(make_header(0, null_hash), 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__push__existing_height__false)
+{
+    header_index instance;
+    BOOST_REQUIRE(instance.push(make_header(0, null_hash), 0));
+    BOOST_REQUIRE(!instance.push(make_header(1, null_hash), 0));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// pop_above
+
+BOOST_AUTO_TEST_CASE(header_index__pop_above__fork_point__expected_size)
+{
+    header_index instance;
+    const auto header0 = make_header(0, null_hash);
+    const auto header1 = make_header(1, header0.hash());
+    const auto header2 = make_header(2, header1.hash());
+    BOOST_REQUIRE(instance.push(header0, 0));
+    BOOST_REQUIRE(instance.push(header1, 1));
+    BOOST_REQUIRE(instance.push(header2, 2));
+    instance.pop_above(0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    hash_digest hash;
+    BOOST_REQUIRE(!instance.get_block_hash(hash, 1));
+}
+
+BOOST_AUTO_TEST_CASE(header_index__pop_above__above_top__unchanged)
+{
+    header_index instance;
+    BOOST_REQUIRE(instance.push(make_header(0, null_hash), 0));
+    instance.pop_above(42);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// clear
+
+BOOST_AUTO_TEST_CASE(header_index__clear__populated__empty)
+{
+    header_index instance;
+    BOOST_REQUIRE(instance.push(make_header(0, null_hash), 0));
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// getters
+
+BOOST_AUTO_TEST_CASE(header_index__getters__not_found__false)
+{
+    const header_index instance;
+    hash_digest hash;
+    uint32_t value;
+    chain::header header;
+    BOOST_REQUIRE(!instance.get_block_hash(hash, 0));
+    BOOST_REQUIRE(!instance.get_bits(value, 0));
+    BOOST_REQUIRE(!instance.get_timestamp(value, 0));
+    BOOST_REQUIRE(!instance.get_version(value, 0));
+    BOOST_REQUIRE(!instance.get_header(header, 0));
+}
+
+BOOST_AUTO_TEST_CASE(header_index__getters__found__expected)
+{
+    header_index instance;
+    const auto header0 = make_header(42, null_hash);
+    BOOST_REQUIRE(instance.push(header0, 0));
+
+    hash_digest hash;
+    uint32_t bits;
+    uint32_t timestamp;
+    uint32_t version;
+    BOOST_REQUIRE(instance.get_block_hash(hash, 0));
+    BOOST_REQUIRE(instance.get_bits(bits, 0));
+    BOOST_REQUIRE(instance.get_timestamp(timestamp, 0));
+    BOOST_REQUIRE(instance.get_version(version, 0));
+    BOOST_REQUIRE(hash == header0.hash());
+    BOOST_REQUIRE_EQUAL(bits, header0.bits());
+    BOOST_REQUIRE_EQUAL(timestamp, header0.timestamp());
+    BOOST_REQUIRE_EQUAL(version, header0.version());
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_header__second__linked_to_first)
+{
+    header_index instance;
+    const auto header0 = make_header(0, null_hash);
+    const auto header1 = make_header(1, header0.hash());
+    BOOST_REQUIRE(instance.push(header0, 0));
+    BOOST_REQUIRE(instance.push(header1, 1));
+
+    chain::header header;
+    BOOST_REQUIRE(instance.get_header(header, 1));
+    BOOST_REQUIRE(header == header1);
+    BOOST_REQUIRE(header.previous_block_hash() == header0.hash());
+    BOOST_REQUIRE_EQUAL(header.validation.height, 1u);
+}
+
+// get_branch_work
+
+static const uint32_t minimum_bits = 0x1d00ffff;
+static const uint256_t minimum_work = 0x100010001;
+
+static void push_minimum_work(header_index& instance, size_t count)
+{
+    auto parent = null_hash;
+
+    for (size_t height = 0; height < count; ++height)
+    {
+        const chain::header header{ 1, parent, null_hash, 0, minimum_bits, 0 };
+        BOOST_REQUIRE(instance.push(header, height));
+        parent = header.hash();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__above_index__false)
+{
+    header_index instance;
+    push_minimum_work(instance, 2);
+    uint256_t work;
+    BOOST_REQUIRE(!instance.get_branch_work(work, max_uint64, 0, 2));
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__from_above_to__zero)
+{
+    header_index instance;
+    push_minimum_work(instance, 2);
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_branch_work(work, max_uint64, 2, 1));
+    BOOST_REQUIRE(work == 0);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__maximum_zero__zero)
+{
+    header_index instance;
+    push_minimum_work(instance, 2);
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_branch_work(work, 0, 0, 1));
+    BOOST_REQUIRE(work == 0);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__unbounded__sum)
+{
+    header_index instance;
+    push_minimum_work(instance, 4);
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_branch_work(work, max_uint64, 1, 3));
+    BOOST_REQUIRE(work == 3 * minimum_work);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__bounded__stops_at_maximum)
+{
+    header_index instance;
+    push_minimum_work(instance, 4);
+    uint256_t work;
+    BOOST_REQUIRE(instance.get_branch_work(work, minimum_work + 1, 0, 3));
+    BOOST_REQUIRE(work == 2 * minimum_work);
+}
+
+BOOST_AUTO_TEST_CASE(header_index__get_branch_work__popped__excluded)
+{
+    header_index instance;
+    push_minimum_work(instance, 4);
+    instance.pop_above(1);
+    uint256_t work;
+    BOOST_REQUIRE(!instance.get_branch_work(work, max_uint64, 0, 2));
+    BOOST_REQUIRE(instance.get_branch_work(work, max_uint64, 0, 1));
+    BOOST_REQUIRE(work == 2 * minimum_work);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(in_flight_transactions_tests)
+
+static hash_digest make_hash(uint8_t id)
+{
+    auto hash = null_hash;
+    hash[0] = id;
+    return hash;
+}
+
+// Spend the given outpoint, the lock time distinguishes spends of it.
+static transaction_const_ptr make_tx(const hash_digest& hash, uint32_t index,
+    uint32_t locktime = 0)
+{
+    chain::input::list inputs;
+    inputs.emplace_back(chain::output_point{ hash, index }, chain::script{}, 0);
+
+    chain::output::list outputs;
+    outputs.emplace_back(1000, chain::script{});
+
+    return std::make_shared<const message::transaction>(
+        chain::transaction(1, locktime, std::move(inputs),
+            std::move(outputs)));
+}
+
+static void ignore(const code&)
+{
+}
+
+// reserve
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__reserve__unspent__true)
+{
+    in_flight_transactions instance;
+    code ec;
+    BOOST_REQUIRE(instance.reserve(make_tx(make_hash(1), 0), ignore, ec));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__reserve__spent_in_flight__double_spend)
+{
+    in_flight_transactions instance;
+    const auto first = make_tx(make_hash(1), 0, 1);
+    const auto second = make_tx(make_hash(1), 0, 2);
+    code ec;
+    BOOST_REQUIRE(instance.reserve(first, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(second, ignore, ec));
+    BOOST_REQUIRE_EQUAL(ec, error::double_spend);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__reserve__same_in_flight__duplicate_transaction)
+{
+    in_flight_transactions instance;
+    const auto tx = make_tx(make_hash(1), 0);
+    code ec;
+    BOOST_REQUIRE(instance.reserve(tx, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(tx, ignore, ec));
+    BOOST_REQUIRE_EQUAL(ec, error::duplicate_transaction);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__reserve__other_output_in_flight__true)
+{
+    in_flight_transactions instance;
+    code ec;
+    BOOST_REQUIRE(instance.reserve(make_tx(make_hash(1), 0), ignore, ec));
+    BOOST_REQUIRE(instance.reserve(make_tx(make_hash(1), 1), ignore, ec));
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__reserve__parent_in_flight__deferred)
+{
+    in_flight_transactions instance;
+    const auto parent = make_tx(make_hash(1), 0);
+    const auto child = make_tx(parent->hash(), 0);
+    code ec = error::double_spend;
+    BOOST_REQUIRE(instance.reserve(parent, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(child, ignore, ec));
+    BOOST_REQUIRE_EQUAL(ec, error::success);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// release
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__release__spent__spend_reservable)
+{
+    in_flight_transactions instance;
+    const auto first = make_tx(make_hash(1), 0, 1);
+    const auto second = make_tx(make_hash(1), 0, 2);
+    code ec;
+    BOOST_REQUIRE(instance.reserve(first, ignore, ec));
+    BOOST_REQUIRE(instance.release(first).empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(instance.reserve(second, ignore, ec));
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__release__deferred_child__child_returned_reservable)
+{
+    in_flight_transactions instance;
+    const auto parent = make_tx(make_hash(1), 0);
+    const auto child = make_tx(parent->hash(), 0);
+    auto notified = false;
+    const auto handler = [&notified](const code&) { notified = true; };
+    code ec;
+    BOOST_REQUIRE(instance.reserve(parent, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(child, handler, ec));
+
+    const auto children = instance.release(parent);
+    BOOST_REQUIRE_EQUAL(children.size(), 1u);
+    BOOST_REQUIRE(children.front().first == child);
+
+    // The organizer reorganizes the child with its own handler.
+    children.front().second(error::success);
+    BOOST_REQUIRE(notified);
+    BOOST_REQUIRE(instance.reserve(child, ignore, ec));
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__release__deferred_children__deferral_order)
+{
+    in_flight_transactions instance;
+    const auto parent = make_tx(make_hash(1), 0);
+    const auto child1 = make_tx(parent->hash(), 0);
+    const auto child2 = make_tx(parent->hash(), 1);
+    code ec;
+    BOOST_REQUIRE(instance.reserve(parent, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(child1, ignore, ec));
+    BOOST_REQUIRE(!instance.reserve(child2, ignore, ec));
+
+    const auto children = instance.release(parent);
+    BOOST_REQUIRE_EQUAL(children.size(), 2u);
+    BOOST_REQUIRE(children[0].first == child1);
+    BOOST_REQUIRE(children[1].first == child2);
+}
+
+BOOST_AUTO_TEST_CASE(in_flight_transactions__release__not_in_flight__empty)
+{
+    in_flight_transactions instance;
+    BOOST_REQUIRE(instance.release(make_tx(make_hash(1), 0)).empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
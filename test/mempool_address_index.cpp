@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::wallet;
+
+BOOST_AUTO_TEST_SUITE(mempool_address_index_tests)
+
+static const short_hash address_hash = base16_literal(
+    "18c0bd8d1818f1bf99cb1df2269c645318ef7b73");
+
+static chain::transaction make_tx(uint64_t value)
+{
+    chain::output::list outputs;
+    outputs.emplace_back(value, chain::script(
+        chain::script::to_pay_key_hash_pattern(address_hash)));
+    return chain::transaction(1, 0, chain::input::list{}, std::move(outputs));
+}
+
+// add
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__output__found)
+{
+    mempool_address_index instance;
+    const auto tx = make_tx(42);
+    instance.add(tx, {}, 7);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto rows = instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2kh));
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_REQUIRE(rows[0].hash == tx.hash());
+    BOOST_REQUIRE_EQUAL(rows[0].index, 0u);
+    BOOST_REQUIRE(!rows[0].spend);
+    BOOST_REQUIRE_EQUAL(rows[0].value, 42u);
+    BOOST_REQUIRE_EQUAL(rows[0].timestamp, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__spend__found_by_prevout_address)
+{
+    mempool_address_index instance;
+    const auto previous = make_tx(42);
+    const chain::output_point point{ previous.hash(), 0 };
+
+    chain::input::list inputs;
+    inputs.emplace_back(chain::output_point{ point }, chain::script{}, 0);
+    const chain::transaction tx(1, 0, std::move(inputs), chain::output::list{});
+
+    instance.add(tx, previous.outputs(), 0);
+    const auto rows = instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2kh));
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_REQUIRE(rows[0].spend);
+    BOOST_REQUIRE_EQUAL(rows[0].value, 42u);
+    BOOST_REQUIRE(rows[0].previous_output == point);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__unresolved_prevout__not_indexed)
+{
+    mempool_address_index instance;
+    chain::input::list inputs;
+    inputs.emplace_back(chain::output_point{ null_hash, 0 }, chain::script{}, 0);
+    const chain::transaction tx(1, 0, std::move(inputs), chain::output::list{});
+
+    instance.add(tx, { chain::output{} }, 0);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2kh)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__testnet_query__found)
+{
+    mempool_address_index instance;
+    instance.add(make_tx(42), {}, 0);
+    BOOST_REQUIRE_EQUAL(instance.get(
+        payment_address(address_hash, payment_address::testnet_p2kh)).size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__p2sh_query__not_found)
+{
+    mempool_address_index instance;
+    instance.add(make_tx(42), {}, 0);
+    BOOST_REQUIRE(instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2sh)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__add__twice__indexed_once)
+{
+    mempool_address_index instance;
+    const auto tx = make_tx(42);
+    instance.add(tx, {}, 0);
+    instance.add(tx, {}, 0);
+    BOOST_REQUIRE_EQUAL(instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2kh)).size(), 1u);
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__remove__indexed__not_found)
+{
+    mempool_address_index instance;
+    const auto tx1 = make_tx(1);
+    const auto tx2 = make_tx(2);
+    instance.add(tx1, {}, 0);
+    instance.add(tx2, {}, 0);
+    instance.remove(tx1.hash());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto rows = instance.get(
+        payment_address(address_hash, payment_address::mainnet_p2kh));
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_REQUIRE(rows[0].hash == tx2.hash());
+}
+
+BOOST_AUTO_TEST_CASE(mempool_address_index__clear__indexed__empty)
+{
+    mempool_address_index instance;
+    instance.add(make_tx(1), {}, 0);
+    instance.clear();
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
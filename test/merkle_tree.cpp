@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(merkle_tree_tests)
+
+static hash_list make_leaves(size_t count, uint8_t seed)
+{
+    hash_list out;
+
+    for (size_t leaf = 0; leaf < count; ++leaf)
+    {
+        auto hash = null_hash;
+        hash[0] = static_cast<uint8_t>(leaf);
+        hash[1] = seed;
+        out.push_back(hash);
+    }
+
+    return out;
+}
+
+// Reference computation, rebuilding every level.
+static hash_digest expected_root(hash_list level)
+{
+    if (level.empty())
+        return null_hash;
+
+    while (level.size() > 1)
+    {
+        if (level.size() % 2 != 0)
+            level.push_back(level.back());
+
+        hash_list above;
+
+        for (size_t node = 0; node < level.size(); node += 2)
+            above.push_back(bitcoin_hash(build_chunk(
+                { level[node], level[node + 1] })));
+
+        level = above;
+    }
+
+    return level.front();
+}
+
+// update
+
+BOOST_AUTO_TEST_CASE(merkle_tree__update__one__empty_branch)
+{
+    merkle_tree instance;
+    instance.update(make_leaves(1, 0));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.branch().empty());
+}
+
+BOOST_AUTO_TEST_CASE(merkle_tree__update__various__expected_root)
+{
+    for (size_t count = 1; count < 20; ++count)
+    {
+        merkle_tree instance;
+        const auto leaves = make_leaves(count, 0);
+        instance.update(leaves);
+        BOOST_REQUIRE(instance.root(leaves.front()) == expected_root(leaves));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_tree__update__changed_suffix__expected_root)
+{
+    merkle_tree instance;
+    instance.update(make_leaves(13, 0));
+
+    // Replace the suffix from leaf 5, then grow and shrink.
+    auto leaves = make_leaves(13, 0);
+    const auto changed = make_leaves(13, 1);
+    std::copy(changed.begin() + 5, changed.end(), leaves.begin() + 5);
+    instance.update(leaves);
+    BOOST_REQUIRE(instance.root(leaves.front()) == expected_root(leaves));
+
+    leaves.push_back(changed.front());
+    instance.update(leaves);
+    BOOST_REQUIRE(instance.root(leaves.front()) == expected_root(leaves));
+
+    leaves.resize(3);
+    instance.update(leaves);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+    BOOST_REQUIRE(instance.root(leaves.front()) == expected_root(leaves));
+}
+
+// branch
+
+BOOST_AUTO_TEST_CASE(merkle_tree__root__other_first__expected_root)
+{
+    merkle_tree instance;
+    auto leaves = make_leaves(7, 0);
+    instance.update(leaves);
+
+    // The branch does not depend on the first leaf (the coinbase).
+    leaves.front() = make_leaves(1, 42).front();
+    BOOST_REQUIRE(instance.root(leaves.front()) == expected_root(leaves));
+    BOOST_REQUIRE_EQUAL(instance.branch().size(), 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
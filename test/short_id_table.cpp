@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(short_id_table_tests)
+
+static const uint64_t key0 = 0x0706050403020100;
+static const uint64_t key1 = 0x0f0e0d0c0b0a0908;
+
+static hash_digest make_hash(uint8_t id)
+{
+    auto hash = null_hash;
+    hash[0] = id;
+    return hash;
+}
+
+// add/remove
+
+BOOST_AUTO_TEST_CASE(short_id_table__add__duplicate__added_once)
+{
+    short_id_table instance;
+    instance.add(make_hash(1), make_hash(1));
+    instance.add(make_hash(1), make_hash(1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(short_id_table__remove__first__last_retained)
+{
+    short_id_table instance;
+    instance.add(make_hash(1), make_hash(11));
+    instance.add(make_hash(2), make_hash(12));
+    instance.remove(make_hash(1));
+    instance.remove(make_hash(3));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto ids = instance.short_ids(key0, key1);
+    BOOST_REQUIRE_EQUAL(ids.size(), 1u);
+    BOOST_REQUIRE(ids[0].second == make_hash(2));
+    BOOST_REQUIRE_EQUAL(ids[0].first,
+        short_id_table::short_id(key0, key1, make_hash(12)));
+}
+
+// resolve
+
+BOOST_AUTO_TEST_CASE(short_id_table__resolve__matched__txids)
+{
+    short_id_table instance;
+
+    for (uint8_t id = 0; id < 100; ++id)
+        instance.add(make_hash(id), make_hash(id + 100));
+
+    const short_id_table::short_id_map short_ids
+    {
+        { short_id_table::short_id(key0, key1, make_hash(142)), 1 },
+        { short_id_table::short_id(key0, key1, make_hash(107)), 2 },
+        { short_id_table::short_id(key0, key1, make_hash(0)), 3 }
+    };
+
+    hash_list txids(4, null_hash);
+    BOOST_REQUIRE_EQUAL(instance.resolve(txids, key0, key1, short_ids), 2u);
+    BOOST_REQUIRE(txids[0] == null_hash);
+    BOOST_REQUIRE(txids[1] == make_hash(42));
+    BOOST_REQUIRE(txids[2] == make_hash(7));
+    BOOST_REQUIRE(txids[3] == null_hash);
+}
+
+BOOST_AUTO_TEST_CASE(short_id_table__resolve__ambiguous__unresolved)
+{
+    short_id_table instance;
+
+    // Two transactions with the same short id hash collide.
+    instance.add(make_hash(1), make_hash(42));
+    instance.add(make_hash(2), make_hash(42));
+
+    const short_id_table::short_id_map short_ids
+    {
+        { short_id_table::short_id(key0, key1, make_hash(42)), 0 }
+    };
+
+    hash_list txids(1, null_hash);
+    BOOST_REQUIRE_EQUAL(instance.resolve(txids, key0, key1, short_ids), 0u);
+    BOOST_REQUIRE(txids[0] == null_hash);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
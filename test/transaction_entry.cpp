@@ -54,11 +54,6 @@ static transaction_const_ptr make_tx()
     return tx;
 }
 
-static transaction_entry::ptr make_instance()
-{
-    return std::make_shared<transaction_entry>(transaction_entry(make_tx()));
-}
-
 // TODO: add populated tx and test property values.
 
 // construct1/tx
@@ -73,8 +68,6 @@ BOOST_AUTO_TEST_CASE(transaction_entry__construct1__default_tx__expected_values)
     BOOST_REQUIRE_EQUAL(instance.size(), 10u);
     BOOST_REQUIRE(instance.hash() == default_tx_hash);
     BOOST_REQUIRE(!instance.is_marked());
-    BOOST_REQUIRE(instance.parents().empty());
-    BOOST_REQUIRE(instance.children().empty());
 }
 
 // construct2/hash
@@ -89,26 +82,6 @@ BOOST_AUTO_TEST_CASE(transaction_entry__construct1__default_block_hash__expected
     BOOST_REQUIRE_EQUAL(instance.size(), 0);
     BOOST_REQUIRE(instance.hash() == default_tx_hash);
     BOOST_REQUIRE(!instance.is_marked());
-    BOOST_REQUIRE(instance.parents().empty());
-    BOOST_REQUIRE(instance.children().empty());
-}
-
-// is_anchor
-
-BOOST_AUTO_TEST_CASE(transaction_entry__is_anchor__parents__false)
-{
-    transaction_entry instance(make_tx());
-    const auto parent = make_instance();
-    instance.add_parent(parent);
-    BOOST_REQUIRE(!instance.is_anchor());
-}
-
-BOOST_AUTO_TEST_CASE(transaction_entry__is_anchor__children__true)
-{
-    transaction_entry instance(make_tx());
-    const auto child = make_instance();
-    instance.add_child(child);
-    BOOST_REQUIRE(instance.is_anchor());
 }
 
 // mark
@@ -143,59 +116,4 @@ BOOST_AUTO_TEST_CASE(transaction_entry__is_marked__true__true)
     BOOST_REQUIRE(instance.is_marked());
 }
 
-// add_parent
-
-BOOST_AUTO_TEST_CASE(transaction_entry__add_parent__one__expected_parents)
-{
-    transaction_entry instance(make_tx());
-    const auto parent = make_instance();
-    instance.add_parent(parent);
-    BOOST_REQUIRE_EQUAL(instance.parents().size(), 1u);
-    BOOST_REQUIRE_EQUAL(instance.parents().front(), parent);
-}
-
-// add_child
-
-BOOST_AUTO_TEST_CASE(transaction_entry__add_child__one__expected_children)
-{
-    transaction_entry instance(make_tx());
-    const auto child = make_instance();
-    instance.add_child(child);
-    BOOST_REQUIRE_EQUAL(instance.children().size(), 1u);
-    BOOST_REQUIRE_EQUAL(instance.children().front(), child);
-}
-
-// remove_child
-
-BOOST_AUTO_TEST_CASE(transaction_entry__remove_child__not_found__empty)
-{
-    transaction_entry instance(make_tx());
-    const auto child = make_instance();
-    instance.remove_child(child);
-    BOOST_REQUIRE(instance.children().empty());
-}
-
-BOOST_AUTO_TEST_CASE(transaction_entry__remove_child__only_found__empty)
-{
-    transaction_entry instance(make_tx());
-    const auto child = make_instance();
-    instance.add_child(child);
-    BOOST_REQUIRE_EQUAL(instance.children().size(), 1u);
-    instance.remove_child(child);
-    BOOST_REQUIRE(instance.children().empty());
-}
-
-BOOST_AUTO_TEST_CASE(transaction_entry__remove_child__one_of_two__expected_one_remains)
-{
-    transaction_entry instance(make_tx());
-    const auto child1 = make_instance();
-    const auto child2 = make_instance();
-    instance.add_child(child1);
-    instance.add_child(child2);
-    BOOST_REQUIRE_EQUAL(instance.children().size(), 2u);
-    instance.remove_child(child1);
-    BOOST_REQUIRE_EQUAL(instance.children().size(), 1u);
-    BOOST_REQUIRE_EQUAL(instance.children().front(), child2);
-}
-
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::blockchain;
+
+BOOST_AUTO_TEST_SUITE(transaction_entry_store_tests)
+
+typedef transaction_entry_store::handles handles;
+
+static chain_state::data data()
+{
+    chain_state::data value;
+    value.height = 1;
+    value.bits = { 0, { 0 } };
+    value.version = { 1, { 0 } };
+    value.timestamp = { 0, 0, { 0 } };
+    return value;
+}
+
+static transaction_entry make_entry(uint32_t locktime)
+{
+    const auto tx = std::make_shared<const message::transaction>(
+        chain::transaction(1, locktime, {}, {}));
+
+    tx->validation.state = std::make_shared<chain_state>(
+#ifdef BITPRIM_CURRENCY_BCH
+        chain_state{ data(), {}, 0, 0, 0 });
+#else
+        chain_state{ data(), {}, 0 });
+#endif //BITPRIM_CURRENCY_BCH
+
+    return transaction_entry(tx);
+}
+
+// insert
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__insert__two__distinct_handles)
+{
+    transaction_entry_store instance;
+    const auto entry1 = make_entry(1);
+    const auto entry2 = make_entry(2);
+    const auto handle1 = instance.insert(transaction_entry(entry1));
+    const auto handle2 = instance.insert(transaction_entry(entry2));
+    BOOST_REQUIRE_NE(handle1, handle2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(instance.get(handle1).hash() == entry1.hash());
+    BOOST_REQUIRE(instance.get(handle2).hash() == entry2.hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__insert__after_erase__slot_reused)
+{
+    transaction_entry_store instance;
+    const auto handle1 = instance.insert(make_entry(1));
+    instance.insert(make_entry(2));
+    instance.erase(handle1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto handle3 = instance.insert(make_entry(3));
+    BOOST_REQUIRE_EQUAL(handle3, handle1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.capacity(), 2u);
+}
+
+// link
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__link__parent_child__linked)
+{
+    transaction_entry_store instance;
+    const auto parent = instance.insert(make_entry(1));
+    const auto child = instance.insert(make_entry(2));
+    BOOST_REQUIRE(instance.link(parent, child));
+    BOOST_REQUIRE(instance.get(parent).is_anchor());
+    BOOST_REQUIRE(!instance.get(child).is_anchor());
+
+    handles parents;
+    handles children;
+    instance.parents(child, parents);
+    instance.children(parent, children);
+    BOOST_REQUIRE_EQUAL(parents.size(), 1u);
+    BOOST_REQUIRE_EQUAL(parents.front(), parent);
+    BOOST_REQUIRE_EQUAL(children.size(), 1u);
+    BOOST_REQUIRE_EQUAL(children.front(), child);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__link__duplicate__false)
+{
+    transaction_entry_store instance;
+    const auto parent = instance.insert(make_entry(1));
+    const auto child = instance.insert(make_entry(2));
+    BOOST_REQUIRE(instance.link(parent, child));
+    BOOST_REQUIRE(!instance.link(parent, child));
+
+    handles children;
+    instance.children(parent, children);
+    BOOST_REQUIRE_EQUAL(children.size(), 1u);
+}
+
+// erase
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__erase__parent__child_anchored)
+{
+    transaction_entry_store instance;
+    const auto parent = instance.insert(make_entry(1));
+    const auto child = instance.insert(make_entry(2));
+    BOOST_REQUIRE(instance.link(parent, child));
+    instance.erase(parent);
+    BOOST_REQUIRE(instance.get(child).is_anchor());
+
+    handles parents;
+    instance.parents(child, parents);
+    BOOST_REQUIRE(parents.empty());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_entry_store__erase__one_of_two_children__other_remains)
+{
+    transaction_entry_store instance;
+    const auto parent = instance.insert(make_entry(1));
+    const auto child1 = instance.insert(make_entry(2));
+    const auto child2 = instance.insert(make_entry(3));
+    BOOST_REQUIRE(instance.link(parent, child1));
+    BOOST_REQUIRE(instance.link(parent, child2));
+    instance.erase(child1);
+
+    handles children;
+    instance.children(parent, children);
+    BOOST_REQUIRE_EQUAL(children.size(), 1u);
+    BOOST_REQUIRE_EQUAL(children.front(), child2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
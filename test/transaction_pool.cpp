@@ -18,9 +18,15 @@
  */
 #include <boost/test/unit_test.hpp>
 // #include <bitcoin/consensus.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
 #include <bitcoin/blockchain.hpp>
 
 using namespace bc;
+using namespace bc::chain;
 using namespace bc::blockchain;
 
 #ifdef WITH_BLOCKCHAIN_REPLIER
@@ -62,8 +68,479 @@ struct fixture {};
 
 BOOST_FIXTURE_TEST_SUITE(transaction_pool_tests, ::fixture)
 
-BOOST_AUTO_TEST_CASE(transaction_pool__construct__foo__bar) {
-    // TODO
+static chain_state::data data()
+{
+    chain_state::data value;
+    value.height = 1;
+    value.bits = { 0, { 0 } };
+    value.version = { 1, { 0 } };
+    value.timestamp = { 0, 0, { 0 } };
+    return value;
+}
+
+// Spend the given prevouts (with their values) to the given output values.
+static transaction_const_ptr make_tx(
+    const std::vector<std::pair<chain::output_point, uint64_t>>& prevouts,
+    const std::vector<uint64_t>& values)
+{
+    chain::input::list inputs;
+    chain::output::list outputs;
+
+    for (const auto& prevout: prevouts)
+    {
+        auto point = prevout.first;
+        point.validation.cache = chain::output(prevout.second, chain::script{});
+        inputs.emplace_back(std::move(point), chain::script{}, 0);
+    }
+
+    for (const auto value: values)
+        outputs.emplace_back(value, chain::script{});
+
+    const auto tx = std::make_shared<const message::transaction>(
+        chain::transaction(1, 0, std::move(inputs), std::move(outputs)));
+
+    tx->validation.state = std::make_shared<chain_state>(
+#ifdef BITPRIM_CURRENCY_BCH
+        chain_state{ data(), {}, 0, 0, 0 });
+#else
+        chain_state{ data(), {}, 0 });
+#endif //BITPRIM_CURRENCY_BCH
+
+    return tx;
+}
+
+// Spend a confirmed (not pooled) output, paying the given fee.
+static transaction_const_ptr make_tx(uint8_t id, uint64_t fee)
+{
+    hash_digest hash = null_hash;
+    hash[0] = id;
+    return make_tx({ { { hash, 0 }, 10000 } }, { 10000 - fee });
+}
+
+static block_const_ptr make_block(const chain::transaction::list& txs)
+{
+    auto copy = txs;
+    return std::make_shared<const message::block>(chain::header{},
+        std::move(copy));
+}
+
+// add
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__unpooled__success)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto tx = make_tx(1, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(tx), error::success);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.exists(tx->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__duplicate__unspent_duplicate)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto tx = make_tx(1, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(tx), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(tx), error::unspent_duplicate);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__pooled_conflict__double_spend)
+{
+    transaction_pool instance(blockchain::settings{});
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 100)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 200)), error::double_spend);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__pooled_parent__ancestors_aggregated)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 100);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9900 } }, { 9500 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 2u);
+    BOOST_REQUIRE(selected[1].hash() == child->hash());
+    BOOST_REQUIRE_EQUAL(selected[1].ancestor_count(), 2u);
+    BOOST_REQUIRE_EQUAL(selected[1].ancestor_fees(), 500u);
+    BOOST_REQUIRE_EQUAL(selected[1].ancestor_size(),
+        selected[0].size() + selected[1].size());
+}
+
+// select
+
+BOOST_AUTO_TEST_CASE(transaction_pool__select__empty__empty)
+{
+    const transaction_pool instance(blockchain::settings{});
+    BOOST_REQUIRE(instance.select().empty());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__select__child_pays_for_parent__parent_first)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 0);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 10000 } }, { 8000 });
+    const auto other = make_tx(2, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(other), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 3u);
+    BOOST_REQUIRE(selected[0].hash() == parent->hash());
+    BOOST_REQUIRE(selected[1].hash() == child->hash());
+    BOOST_REQUIRE(selected[2].hash() == other->hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__select__size_limit__highest_feerate_only)
+{
+    const auto low = make_tx(1, 100);
+    const auto high = make_tx(2, 200);
+    const transaction_entry entry(low);
+    transaction_pool instance(blockchain::settings{}, entry.size() * 3 / 2);
+    BOOST_REQUIRE_EQUAL(instance.add(low), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(high), error::success);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].hash() == high->hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__select__rejected_parent__child_not_selected)
+{
+    // The parent is too large for the template, its child pays a high fee.
+    const auto parent = make_tx({ { { hash_digest{ { 1 } }, 0 }, 10000 } },
+        { 5000, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+          1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 });
+    const auto child = make_tx({ { { parent->hash(), 0 }, 5000 } }, { 1000 });
+    const auto other = make_tx(2, 100);
+    const transaction_entry entry(other);
+    transaction_pool instance(blockchain::settings{}, entry.size() * 3);
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(other), error::success);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].hash() == other->hash());
+}
+
+// selection
+
+BOOST_AUTO_TEST_CASE(transaction_pool__selection__unchanged__retained)
+{
+    transaction_pool instance(blockchain::settings{});
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 100)), error::success);
+
+    const auto first = instance.selection();
+    const auto second = instance.selection();
+    BOOST_REQUIRE_EQUAL(first.size(), 1u);
+    BOOST_REQUIRE(first[0].hash() == second[0].hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__selection__added__reselected)
+{
+    transaction_pool instance(blockchain::settings{});
+    BOOST_REQUIRE(instance.selection().empty());
+
+    const auto tx = make_tx(1, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(tx), error::success);
+    const auto selected = instance.selection();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].hash() == tx->hash());
+
+    instance.remove(make_block({ *tx }));
+    BOOST_REQUIRE(instance.selection().empty());
+}
+
+// fetch_template
+
+BOOST_AUTO_TEST_CASE(transaction_pool__fetch_template__pooled__selection_order_and_height)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 10);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9990 } }, { 8990 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    instance.fetch_template(42,
+        [&](const code& ec, merkle_block_ptr block, size_t height)
+        {
+            BOOST_REQUIRE_EQUAL(ec, error::success);
+            BOOST_REQUIRE_EQUAL(height, 42u);
+            BOOST_REQUIRE_EQUAL(block->total_transactions(), 2u);
+            BOOST_REQUIRE_EQUAL(block->hashes().size(), 2u);
+            BOOST_REQUIRE(block->hashes()[0] == parent->hash());
+            BOOST_REQUIRE(block->hashes()[1] == child->hash());
+        });
+}
+
+// descendants
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__pooled_child__descendants_aggregated)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 100);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9900 } }, { 9500 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 2u);
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_count(), 2u);
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_fees(), 500u);
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_size(),
+        selected[0].size() + selected[1].size());
+    BOOST_REQUIRE_EQUAL(selected[1].descendant_count(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(),
+        selected[0].size() + selected[1].size());
+}
+
+// evict
+
+static blockchain::settings capacity_settings(size_t transactions)
+{
+    blockchain::settings settings;
+    settings.transaction_pool_capacity = transactions *
+        make_tx(0, 0)->serialized_size();
+    return settings;
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__over_capacity__lowest_feerate_evicted)
+{
+    transaction_pool instance(capacity_settings(2));
+    const auto low = make_tx(1, 100);
+    BOOST_REQUIRE_EQUAL(instance.minimum_fee(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.add(low), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(2, 300)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(3, 200)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(!instance.exists(low->hash()));
+
+    const auto evicted = 100u * 1000 / low->serialized_size();
+    BOOST_REQUIRE_GE(instance.minimum_fee(), evicted);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__over_capacity_lowest__insufficient_fee)
+{
+    transaction_pool instance(capacity_settings(2));
+    const auto low = make_tx(3, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 300)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(2, 200)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(low), error::insufficient_fee);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    BOOST_REQUIRE(!instance.exists(low->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__over_capacity__package_evicted_by_descendant_feerate)
+{
+    transaction_pool instance(capacity_settings(3));
+    const auto parent = make_tx(1, 10);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9990 } }, { 9000 });
+    const auto other = make_tx(2, 200);
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(other), error::success);
+
+    // The parent's package pays more than the other, so the other goes.
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(3, 300)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.size(), 3u);
+    BOOST_REQUIRE(instance.exists(parent->hash()));
+    BOOST_REQUIRE(instance.exists(child->hash()));
+    BOOST_REQUIRE(!instance.exists(other->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__over_capacity__evicted_package_returned)
+{
+    transaction_pool instance(capacity_settings(3));
+    const auto parent = make_tx(1, 10);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9990 } }, { 9980 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(2, 200)), error::success);
+
+    hash_list evicted;
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(3, 300), evicted), error::success);
+    BOOST_REQUIRE_EQUAL(evicted.size(), 2u);
+    BOOST_REQUIRE(evicted[0] == child->hash());
+    BOOST_REQUIRE(evicted[1] == parent->hash());
+    BOOST_REQUIRE(!instance.exists(parent->hash()));
+    BOOST_REQUIRE(!instance.exists(child->hash()));
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__add__over_capacity_lowest__self_returned)
+{
+    transaction_pool instance(capacity_settings(2));
+    const auto low = make_tx(3, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 300)), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(2, 200)), error::success);
+
+    hash_list evicted;
+    BOOST_REQUIRE_EQUAL(instance.add(low, evicted), error::insufficient_fee);
+    BOOST_REQUIRE_EQUAL(evicted.size(), 1u);
+    BOOST_REQUIRE(evicted.front() == low->hash());
+}
+
+// remove
+
+BOOST_AUTO_TEST_CASE(transaction_pool__remove__confirmed_parent__child_anchored)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 100);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9900 } }, { 9500 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    instance.remove(make_block({ *parent }));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(!instance.exists(parent->hash()));
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].is_anchor());
+    BOOST_REQUIRE_EQUAL(selected[0].ancestor_count(), 1u);
+    BOOST_REQUIRE_EQUAL(selected[0].ancestor_fees(), 400u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__remove__confirmed_conflict__descendants_removed)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 100);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9900 } }, { 9500 });
+    const auto other = make_tx(2, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(other), error::success);
+
+    instance.remove(make_block({ *make_tx(1, 300) }));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.exists(other->hash()));
+
+    // The conflicting spend is released with the conflict.
+    BOOST_REQUIRE_EQUAL(instance.add(make_tx(1, 400)), error::success);
+}
+
+// fetch_mempool
+
+static hash_list fetch_mempool(const transaction_pool& instance,
+    size_t maximum, uint64_t minimum_fee)
+{
+    hash_list out;
+    instance.fetch_mempool(maximum, minimum_fee,
+        [&](const code& ec, inventory_ptr inventory)
+        {
+            BOOST_REQUIRE_EQUAL(ec, error::success);
+
+            for (const auto& item: inventory->inventories())
+                out.push_back(item.hash());
+        });
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__fetch_mempool__minimum_fee__low_feerate_excluded)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto low = make_tx(1, 100);
+    const auto high = make_tx(2, 1000);
+    BOOST_REQUIRE_EQUAL(instance.add(low), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(high), error::success);
+
+    // Both are the same size, so the minimum falls between their feerates.
+    const auto minimum = 550 * 1000 / high->serialized_size();
+    const auto hashes = fetch_mempool(instance, 10, minimum);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(hashes[0] == high->hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__fetch_mempool__maximum__highest_feerate_first)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto tx1 = make_tx(1, 100);
+    const auto tx2 = make_tx(2, 300);
+    const auto tx3 = make_tx(3, 200);
+    BOOST_REQUIRE_EQUAL(instance.add(tx1), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(tx2), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(tx3), error::success);
+
+    const auto hashes = fetch_mempool(instance, 2, 0);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+    BOOST_REQUIRE(hashes[0] == tx2->hash());
+    BOOST_REQUIRE(hashes[1] == tx3->hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__fetch_mempool__high_fee_child__parent_first)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 10);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9990 } }, { 8990 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+
+    const auto hashes = fetch_mempool(instance, 10, 0);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 2u);
+    BOOST_REQUIRE(hashes[0] == parent->hash());
+    BOOST_REQUIRE(hashes[1] == child->hash());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__fetch_mempool__removed__excluded)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto tx = make_tx(1, 100);
+    BOOST_REQUIRE_EQUAL(instance.add(tx), error::success);
+    instance.remove(make_block({ *tx }));
+    BOOST_REQUIRE(fetch_mempool(instance, 10, 0).empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(transaction_pool__remove__child_before_parent__grandchild_anchored)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto parent = make_tx(1, 100);
+    const auto child = make_tx({ { { parent->hash(), 0 }, 9900 } }, { 9700 });
+    const auto grandchild = make_tx({ { { child->hash(), 0 }, 9700 } },
+        { 9400 });
+    BOOST_REQUIRE_EQUAL(instance.add(parent), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(child), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(grandchild), error::success);
+
+    // Canonical order may place the child before its parent.
+    instance.remove(make_block({ *child, *parent }));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].hash() == grandchild->hash());
+    BOOST_REQUIRE(selected[0].is_anchor());
+    BOOST_REQUIRE_EQUAL(selected[0].ancestor_count(), 1u);
+    BOOST_REQUIRE_EQUAL(selected[0].ancestor_size(), selected[0].size());
+    BOOST_REQUIRE_EQUAL(selected[0].ancestor_fees(), 300u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool__remove__conflicted_middle__ancestor_descendants_reduced)
+{
+    transaction_pool instance(blockchain::settings{});
+    const auto a = make_tx(1, 100);
+    const auto b = make_tx({ { { a->hash(), 0 }, 9900 } }, { 9700 });
+    const auto c = make_tx({ { { b->hash(), 0 }, 9700 } }, { 9400 });
+    BOOST_REQUIRE_EQUAL(instance.add(a), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(b), error::success);
+    BOOST_REQUIRE_EQUAL(instance.add(c), error::success);
+
+    // A confirmed spend of the output of a that b spends conflicts b and c.
+    instance.remove(make_block({ *make_tx({ { { a->hash(), 0 }, 9900 } },
+        { 9000 }) }));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), a->serialized_size());
+
+    const auto selected = instance.select();
+    BOOST_REQUIRE_EQUAL(selected.size(), 1u);
+    BOOST_REQUIRE(selected[0].hash() == a->hash());
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_count(), 1u);
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_size(), selected[0].size());
+    BOOST_REQUIRE_EQUAL(selected[0].descendant_fees(), 100u);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
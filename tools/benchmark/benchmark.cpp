@@ -0,0 +1,393 @@
+/**
+ * Copyright (c) 2016-2018 Bitprim Inc.
+ *
+ * This file is part of Bitprim.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/format.hpp>
+#include <bitcoin/blockchain.hpp>
+
+#define BS_BENCHMARK_USAGE \
+    "Usage: benchmark <case> [count]\n" \
+    "Cases:\n" \
+    "  remove   Remove a block of pooled transactions from a pool of count\n" \
+    "           (default 100000).\n" \
+    "  select   Select a template from a pool of count (default 50000), in\n" \
+    "           chains of unconfirmed parents and children.\n" \
+    "  shortids Resolve the short ids of a compact block against tables of\n" \
+    "           increasing size, up to count (default 300000).\n" \
+    "  entries  Store count (default 300000) linked pool entries, report\n" \
+    "           their memory and time a traversal of all of their links.\n" \
+    "  admit    Admit a flood of count (default 1000000) transactions to the\n" \
+    "           in flight set from every core, with one in ten conflicting.\n"
+#define BS_BENCHMARK_CASE_FAIL \
+    "Failed to set up case %1%.\n"
+#define BS_BENCHMARK_REMOVE \
+    "remove: %1% confirmed of %2% pooled in %3% ms.\n"
+#define BS_BENCHMARK_SELECT \
+    "select: %1% selected of %2% pooled in %3% ms.\n"
+#define BS_BENCHMARK_SHORT_IDS \
+    "shortids: %1% of %2% resolved from %3% entries in %4% ms.\n"
+#define BS_BENCHMARK_ENTRIES_MEMORY \
+    "entries: %1% stored in %2% slots of %3% bytes.\n"
+#define BS_BENCHMARK_ENTRIES_TRAVERSAL \
+    "entries: %1% links traversed in %2% ms.\n"
+#define BS_BENCHMARK_ADMIT \
+    "admit: %1% transactions (%2% conflicts) on %3% threads in %4% ms, " \
+    "%5% tx/s.\n"
+
+using namespace bc;
+using namespace bc::blockchain;
+using namespace bc::chain;
+using boost::format;
+
+typedef std::chrono::steady_clock timer;
+typedef std::vector<std::pair<output_point, uint64_t>> prevout_list;
+
+// Milliseconds elapsed since the start.
+static double elapsed(timer::time_point start)
+{
+    const auto span = timer::now() - start;
+    return std::chrono::duration<double, std::milli>(span).count();
+}
+
+static chain_state::ptr make_state()
+{
+    chain_state::data data;
+    data.height = 1;
+    data.bits = { 0, { 0 } };
+    data.version = { 1, { 0 } };
+    data.timestamp = { 0, 0, { 0 } };
+
+#ifdef BITPRIM_CURRENCY_BCH
+    return std::make_shared<chain_state>(chain_state{ data, {}, 0, 0, 0 });
+#else
+    return std::make_shared<chain_state>(chain_state{ data, {}, 0 });
+#endif
+}
+
+// A confirmed (not pooled) outpoint distinct for each id.
+static output_point make_point(uint32_t id)
+{
+    return{ bitcoin_hash(to_chunk(to_little_endian(id))), 0 };
+}
+
+// Spend the given prevouts (with their values) to the given output values.
+static transaction_const_ptr make_tx(const prevout_list& prevouts,
+    const std::vector<uint64_t>& values, chain_state::ptr state)
+{
+    input::list inputs;
+    output::list outputs;
+
+    for (const auto& prevout: prevouts)
+    {
+        auto point = prevout.first;
+        point.validation.cache = output(prevout.second, script{});
+        inputs.emplace_back(std::move(point), script{}, 0);
+    }
+
+    for (const auto value: values)
+        outputs.emplace_back(value, script{});
+
+    const auto tx = std::make_shared<const message::transaction>(
+        transaction(1, 0, std::move(inputs), std::move(outputs)));
+
+    tx->validation.state = state;
+    return tx;
+}
+
+// Spend a confirmed output of the id, paying a fee that varies by id.
+static transaction_const_ptr make_tx(uint32_t id, chain_state::ptr state)
+{
+    static const uint64_t value = 100000;
+    const uint64_t fee = 100 + id % 1000;
+    return make_tx({ { make_point(id), value } }, { value - fee }, state);
+}
+
+// Block arrival cleanup, removing a full block of transactions from a large
+// pool (the chosen list of a 100k transaction template).
+static bool benchmark_remove(size_t count)
+{
+    static const size_t block_transactions = 2500;
+
+    const auto state = make_state();
+    transaction_pool pool(blockchain::settings{});
+    transaction::list confirmed;
+
+    for (uint32_t id = 0; id < count; ++id)
+    {
+        const auto tx = make_tx(id, state);
+
+        if (pool.add(tx) != error::success)
+            return false;
+
+        if (confirmed.size() < block_transactions)
+            confirmed.push_back(*tx);
+    }
+
+    const auto confirmed_count = confirmed.size();
+    const auto block = std::make_shared<const message::block>(header{},
+        std::move(confirmed));
+
+    const auto start = timer::now();
+    pool.remove(block);
+    const auto span = elapsed(start);
+
+    std::cout << format(BS_BENCHMARK_REMOVE) % confirmed_count % count % span;
+    return pool.size() == count - confirmed_count;
+}
+
+// Template selection over a pool in which every transaction is one of a
+// chain, so that packages of up to chain_length ancestors are scored.
+static bool benchmark_select(size_t count)
+{
+    static const size_t chain_length = 5;
+
+    const auto state = make_state();
+    transaction_pool pool(blockchain::settings{});
+    transaction_const_ptr parent;
+
+    for (uint32_t id = 0; id < count; ++id)
+    {
+        // Children pay more than their parents, so packages are reordered.
+        const auto tx = id % chain_length == 0 ? make_tx(id, state) :
+            make_tx({ { { parent->hash(), 0 },
+                parent->outputs().front().value() } },
+                { parent->outputs().front().value() - 200 * (id % 7 + 1) },
+                state);
+
+        if (pool.add(tx) != error::success)
+            return false;
+
+        parent = tx;
+    }
+
+    const auto start = timer::now();
+    const auto selected = pool.select();
+    const auto span = elapsed(start);
+
+    std::cout << format(BS_BENCHMARK_SELECT) % selected.size() % count % span;
+    return !selected.empty();
+}
+
+// Compact block reconstruction latency against the mempool size, resolving
+// the short ids of a block of pooled transactions under new SipHash keys.
+static bool benchmark_short_ids(size_t count)
+{
+    static const size_t block_transactions = 2500;
+    static const uint64_t k0 = 0x0706050403020100;
+    static const uint64_t k1 = 0x0f0e0d0c0b0a0908;
+
+    short_id_table table;
+
+    for (size_t size = 1000; ; size *= 10)
+    {
+        const auto entries = std::min(size, count);
+
+        for (auto id = static_cast<uint32_t>(table.size()); id < entries; ++id)
+        {
+            const auto hash = bitcoin_hash(to_chunk(to_little_endian(id)));
+            table.add(hash, hash);
+        }
+
+        // Every stride-th entry is in the block.
+        const auto slots = std::min(block_transactions, entries);
+        const auto stride = entries / slots;
+        short_id_table::short_id_map short_ids;
+
+        for (size_t slot = 0; slot < slots; ++slot)
+        {
+            const auto id = static_cast<uint32_t>(slot * stride);
+            const auto hash = bitcoin_hash(to_chunk(to_little_endian(id)));
+            short_ids.emplace(short_id_table::short_id(k0, k1, hash),
+                static_cast<uint16_t>(slot));
+        }
+
+        hash_list txids(slots, null_hash);
+        const auto start = timer::now();
+        const auto resolved = table.resolve(txids, k0, k1, short_ids);
+        const auto span = elapsed(start);
+
+        std::cout << format(BS_BENCHMARK_SHORT_IDS) % resolved % slots %
+            entries % span;
+
+        // Short id collisions are possible, but not at these sizes.
+        if (resolved != short_ids.size())
+            return false;
+
+        if (entries == count)
+            return true;
+    }
+}
+
+// Memory of the entry slab and traversal of the parent and child links, for
+// a mempool of count entries in chains of chain_length. The memory excludes
+// the transactions (shared with their messages) and the link slab.
+static bool benchmark_entries(size_t count)
+{
+    static const size_t chain_length = 25;
+
+    const auto state = make_state();
+    transaction_entry_store store;
+    transaction_entry_store::handles handles;
+    handles.reserve(count);
+
+    for (uint32_t id = 0; id < count; ++id)
+    {
+        const auto entry = store.insert(transaction_entry(make_tx(id, state)));
+
+        if (id % chain_length != 0 && !store.link(handles.back(), entry))
+            return false;
+
+        handles.push_back(entry);
+    }
+
+    std::cout << format(BS_BENCHMARK_ENTRIES_MEMORY) % store.size() %
+        store.capacity() % sizeof(transaction_entry);
+
+    transaction_entry_store::handles links;
+    size_t traversed = 0;
+    const auto start = timer::now();
+
+    for (const auto entry: handles)
+    {
+        links.clear();
+        store.parents(entry, links);
+        store.children(entry, links);
+        traversed += links.size();
+    }
+
+    const auto span = elapsed(start);
+    std::cout << format(BS_BENCHMARK_ENTRIES_TRAVERSAL) % traversed % span;
+    return traversed == 2 * (count - (count + chain_length - 1) / chain_length);
+}
+
+// Throughput of the serialized step of concurrent admission, the outpoint
+// conflict check, under a flood of transactions from every core. Each thread
+// holds a window of transactions in flight, as organize holds them from
+// reserve to release, and one in ten spends the outpoint of its predecessor.
+static bool benchmark_admit(size_t count)
+{
+    static const size_t window = 64;
+
+    const auto state = make_state();
+    const auto threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const auto share = count / threads;
+    std::vector<std::vector<transaction_const_ptr>> floods(threads);
+
+    for (size_t thread = 0; thread < threads; ++thread)
+    {
+        for (size_t index = 0; index < share; ++index)
+        {
+            const auto id = static_cast<uint32_t>(thread * share + index);
+            const auto point = make_point(id % 10 == 9 ? id - 1 : id);
+            floods[thread].push_back(make_tx({ { point, 100000 } },
+                { 100000 - 100 - id % 1000 }, state));
+        }
+    }
+
+    in_flight_transactions in_flight;
+    std::atomic<size_t> conflicts(0);
+    std::vector<std::thread> workers;
+    const auto handler = [](const code&) {};
+    const auto start = timer::now();
+
+    for (size_t thread = 0; thread < threads; ++thread)
+    {
+        workers.emplace_back([&, thread]()
+        {
+            const auto& flood = floods[thread];
+            std::vector<transaction_const_ptr> reserved;
+            code ec;
+
+            for (size_t first = 0; first < flood.size(); first += window)
+            {
+                const auto last = std::min(first + window, flood.size());
+
+                for (auto index = first; index < last; ++index)
+                {
+                    if (in_flight.reserve(flood[index], handler, ec))
+                        reserved.push_back(flood[index]);
+                    else if (ec == error::double_spend)
+                        ++conflicts;
+                }
+
+                for (const auto& tx: reserved)
+                    in_flight.release(tx);
+
+                reserved.clear();
+            }
+        });
+    }
+
+    for (auto& worker: workers)
+        worker.join();
+
+    const auto span = elapsed(start);
+    const auto admitted = share * threads;
+    std::cout << format(BS_BENCHMARK_ADMIT) % admitted % conflicts.load() %
+        threads % span % static_cast<size_t>(admitted * 1000 / span);
+
+    return in_flight.size() == 0;
+}
+
+static int usage()
+{
+    std::cerr << BS_BENCHMARK_USAGE;
+    return -1;
+}
+
+// Time the pool and template operations on synthetic transactions.
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        return usage();
+
+    const std::string name(argv[1]);
+    const size_t count = argc > 2 ? std::stoul(argv[2]) : 0;
+    bool result;
+
+    if (name == "remove")
+        result = benchmark_remove(count == 0 ? 100000 : count);
+    else if (name == "select")
+        result = benchmark_select(count == 0 ? 50000 : count);
+    else if (name == "shortids")
+        result = benchmark_short_ids(count == 0 ? 300000 : count);
+    else if (name == "entries")
+        result = benchmark_entries(count == 0 ? 300000 : count);
+    else if (name == "admit")
+        result = benchmark_admit(count == 0 ? 1000000 : count);
+    else
+        return usage();
+
+    if (!result)
+    {
+        std::cerr << format(BS_BENCHMARK_CASE_FAIL) % name;
+        return -1;
+    }
+
+    return 0;
+}